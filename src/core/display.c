@@ -0,0 +1,136 @@
+#include "display.h"
+#include "../io/ppu.h"
+#include "../io/joypad.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Emulation thread: applies the key events queued since the last call.
+// Returns 0 once the window has been closed.
+int display_poll(Display* display, GB* gb)
+{
+    unsigned tail = atomic_load_explicit(&display->input_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&display->input_head, memory_order_acquire);
+    for (; tail != head; tail++)
+        handle_input(gb, &display->input[tail % INPUT_QUEUE_SIZE]);
+    atomic_store_explicit(&display->input_tail, tail, memory_order_release);
+    return !atomic_load_explicit(&display->quit, memory_order_relaxed);
+}
+
+// Emulation thread, at VBlank: hands the frame just drawn to the presenter and
+// takes the ppu's changed lines with it
+void display_publish(Display* display, PPU* ppu)
+{
+    FrameSlot* slot = &display->slots[display->back];
+    memcpy(slot->shades, ppu->framebuffer, sizeof(slot->shades));
+    memcpy(slot->changed, ppu->lines.changed, sizeof(slot->changed));
+    ppu_clear_changed(ppu);
+
+    // A frame still waiting in middle gets replaced before it's shown, so its
+    // lines have to go out with this one. If the presenter takes it in the
+    // meantime they just get uploaded twice.
+    int middle = atomic_load_explicit(&display->middle, memory_order_acquire);
+    if (middle & FRAME_FRESH)
+    {
+        const uint8_t* skipped = display->slots[middle & 3].changed;
+        for (int y = 0; y < 144; y++)
+            slot->changed[y] |= skipped[y];
+    }
+
+    middle = atomic_exchange_explicit(&display->middle, display->back | FRAME_FRESH, memory_order_acq_rel);
+    display->back = middle & 3;
+}
+
+// Emulation thread: the emulator stopped on its own (--frames, stuck CPU)
+void display_close(Display* display)
+{
+    atomic_store_explicit(&display->quit, 1, memory_order_relaxed);
+}
+
+// Presenter: a full queue drops the event rather than wait on the emulator
+static void queue_input(Display* display, const SDL_Event* event)
+{
+    unsigned head = atomic_load_explicit(&display->input_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&display->input_tail, memory_order_acquire);
+    if (head - tail == INPUT_QUEUE_SIZE) return;
+    display->input[head % INPUT_QUEUE_SIZE] = *event;
+    atomic_store_explicit(&display->input_head, head + 1, memory_order_release);
+}
+
+static void frame_done(void* data)
+{
+    Display* display = data;
+    display_publish(display, &display->gb->ppu);
+}
+
+static int emulate(void* data)
+{
+    Display* display = data;
+    emu_loop(display->gb, display, display->opts);
+    display_close(display);
+    return 0;
+}
+
+// Runs the emulator on a new thread and presents its frames on this one, which
+// has to be the thread SDL was initialized on. Returns when either side quits.
+void display_run(SDL_Context* context, GB* gb, Options* opts)
+{
+    Display* display = calloc(1, sizeof(Display));
+    if (!display)
+    {
+        fprintf(stderr, "Failed to allocate display buffers.\n");
+        return;
+    }
+    display->gb = gb;
+    display->opts = opts;
+    display->back = 0;
+    display->front = 1;
+    atomic_init(&display->middle, 2);
+    atomic_init(&display->input_head, 0);
+    atomic_init(&display->input_tail, 0);
+    atomic_init(&display->quit, 0);
+
+    ppu_set_frame_sink(gb, frame_done, display);
+    SDL_Thread* thread = SDL_CreateThread(emulate, "emulation", display);
+    if (!thread)
+    {
+        fprintf(stderr, "SDL_CreateThread error: %s\n", SDL_GetError());
+        ppu_set_frame_sink(gb, NULL, NULL);
+        free(display);
+        return;
+    }
+
+    uint8_t all_lines[144];
+    memset(all_lines, 1, sizeof(all_lines));
+    int repaint = 1;
+    SDL_Event event;
+    while (!atomic_load_explicit(&display->quit, memory_order_relaxed))
+    {
+        while (SDL_PollEvent(&event))
+        {
+            if (event.type == SDL_QUIT)
+                atomic_store_explicit(&display->quit, 1, memory_order_relaxed);
+            else if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)
+                queue_input(display, &event);
+            // Only changed lines get uploaded, so anything that may have lost
+            // the window or texture contents needs the whole frame again
+            else if (event.type == SDL_WINDOWEVENT || event.type == SDL_RENDER_TARGETS_RESET ||
+                     event.type == SDL_RENDER_DEVICE_RESET)
+                repaint = 1;
+        }
+
+        int fresh = atomic_load_explicit(&display->middle, memory_order_relaxed) & FRAME_FRESH;
+        if (fresh)
+            display->front = atomic_exchange_explicit(&display->middle, display->front, memory_order_acq_rel) & 3;
+        const FrameSlot* slot = &display->slots[display->front];
+        if (fresh || repaint)
+            render_frame(context->renderer, context->texture, slot->shades, repaint ? all_lines : slot->changed);
+        else
+            SDL_Delay(1);
+        repaint = 0;
+    }
+
+    SDL_WaitThread(thread, NULL);
+    ppu_set_frame_sink(gb, NULL, NULL);
+    free(display);
+}
@@ -0,0 +1,42 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include "gb.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <SDL2/SDL.h>
+
+#define INPUT_QUEUE_SIZE 64  // power of two
+#define FRAME_FRESH 4        // in Display.middle: the slot there hasn't been shown
+
+// One drawn frame on its way from the emulation thread to the window
+typedef struct {
+    uint8_t shades[144][160];
+    uint8_t changed[144];   // lines that differ from the frame published before it
+} FrameSlot;
+
+// With a window, the emulator runs on its own thread and never waits on SDL.
+// Frames go through a triple buffer: the emulator fills back, the presenter
+// shows front, and each side swaps its slot with middle in one atomic exchange.
+// Key events go the other way through a single producer, single consumer ring.
+struct Display {
+    FrameSlot slots[3];
+    int back;               // emulation thread only
+    int front;              // presenter only
+    atomic_int middle;      // slot index, plus FRAME_FRESH
+
+    SDL_Event input[INPUT_QUEUE_SIZE];
+    atomic_uint input_head; // written by the presenter
+    atomic_uint input_tail; // written by the emulator
+    atomic_int quit;        // either side is done
+
+    GB* gb;
+    Options* opts;
+};
+
+void display_run(SDL_Context* context, GB* gb, Options* opts);
+int display_poll(Display* display, GB* gb);
+void display_publish(Display* display, PPU* ppu);
+void display_close(Display* display);
+
+#endif
@@ -1,18 +1,86 @@
 #include "gb.h"
 #include "../memory/memory.h"
 #include "../cpu/cpu.h"
+#include "../cpu/blocks.h"
+#include "../cpu/jit.h"
 #include "../io/ppu.h"
 #include "../io/joypad.h"
 #include "../debug/debug.h"
+#include "../core/scheduler.h"
+#include "display.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 Options parse_cli(int count, char** args)
 {
-    Options opts = { NULL, NULL };
+    Options opts = { NULL, NULL, 0, 0, 0, 1, 0, 0, 1 };
     for (int i = 1; i < count; i++) 
     {
+        if (strcmp(args[i], "--headless") == 0)
+        {
+            opts.headless = 1;
+            continue;
+        }
+        if (strcmp(args[i], "--frames") == 0 && i + 1 < count)
+        {
+            opts.frames = (uint32_t)strtoul(args[++i], NULL, 10);
+            continue;
+        }
+        if (strcmp(args[i], "--save-interval") == 0 && i + 1 < count)
+        {
+            opts.save_interval = (uint32_t)strtoul(args[++i], NULL, 10);
+            continue;
+        }
+        if (strcmp(args[i], "--no-save-on-disable") == 0)
+        {
+            opts.save_on_disable = 0;
+            continue;
+        }
+        if (strcmp(args[i], "--frameskip") == 0 && i + 1 < count)
+        {
+            opts.frameskip = (uint32_t)strtoul(args[++i], NULL, 10);
+            continue;
+        }
+        if (strcmp(args[i], "--no-video") == 0)
+        {
+            opts.video = 0;
+            continue;
+        }
+        if (strcmp(args[i], "--bench-ppu") == 0)
+        {
+            opts.bench_ppu = 1;
+            continue;
+        }
+        if (strcmp(args[i], "--no-idle-skip") == 0)
+        {
+            idle_skip_enabled = 0;
+            continue;
+        }
+        if (strcmp(args[i], "--no-simd") == 0)
+        {
+            simd_enabled = 0;
+            continue;
+        }
+        if (strcmp(args[i], "--no-block-cache") == 0)
+        {
+            block_cache_enabled = 0;
+            continue;
+        }
+#ifdef JIT
+        if (strcmp(args[i], "--no-jit") == 0)
+        {
+            jit_enabled = 0;
+            continue;
+        }
+        if (strcmp(args[i], "--jit-verify") == 0)
+        {
+            jit_verify = 1;
+            continue;
+        }
+#endif
+#ifndef STRIP_DEBUG
         if (strcmp(args[i], "--debug") == 0 
             || strcmp(args[i], "-d") == 0) 
         {
@@ -27,6 +95,13 @@ Options parse_cli(int count, char** args)
             dbg.dbg_boot = 1;
         if (strcmp(args[i], "-dMEM") == 0)
             dbg.dbg_mem = 1;
+#else
+        if (strcmp(args[i], "--debug") == 0 || strncmp(args[i], "-d", 2) == 0)
+        {
+            fprintf(stderr, "Debug output is compiled out of this build, ignoring %s\n", args[i]);
+            continue;
+        }
+#endif
     
         if (!opts.game_path) 
         {
@@ -41,9 +116,9 @@ Options parse_cli(int count, char** args)
         }
     }
     
-    if (!opts.game_path) 
+    if (!opts.game_path || (opts.headless && !opts.frames)) 
     {
-        printf("Usage: %s [--debug] <game.gb> [boot.gb]\n", args[0]);
+        printf("Usage: %s [--debug] [--no-block-cache] [--no-idle-skip] [--no-simd] [--headless --frames N] [--frameskip N] [--no-video] [--save-interval S] [--no-save-on-disable] [--bench-ppu] <game.gb> [boot.gb]\n", args[0]);
         exit(EXIT_FAILURE);
     }
     return opts; 
@@ -74,7 +149,7 @@ void cleanup_sdl(SDL_Context* context)
     SDL_Quit();
 }
 
-static void bootstrap(char* rom)
+static void bootstrap(GB* gb, char* rom)
 {
     FILE* bootstrap = fopen(rom, "rb");
     if (!bootstrap)
@@ -83,7 +158,7 @@ static void bootstrap(char* rom)
         exit(EXIT_FAILURE);
     }
     
-    size_t bootstrap_size = fread(boot_rom, 1, 0x0100, bootstrap);
+    size_t bootstrap_size = fread(gb->boot_rom, 1, 0x0100, bootstrap);
     fclose(bootstrap);
     
     if (bootstrap_size != 0x0100) 
@@ -93,56 +168,57 @@ static void bootstrap(char* rom)
     }
     
     printf("Bootstrap ROM loaded. (%zu bytes)\n", bootstrap_size);
-    bootstrap_enabled = 1;
+    gb->bootstrap_enabled = 1;
+    memory_remap(gb, 0x00, 0x00);
 }
 
-static void init_hardware_regs()
+static void init_hardware_regs(GB* gb)
 {
-    // Initialize hardware registers to post-boot values
-    memory[0xFF05] = 0x00;   // TIMA
-    memory[0xFF06] = 0x00;   // TMA
-    memory[0xFF07] = 0x00;   // TAC
-    memory[0xFF10] = 0x80;   // NR10
-    memory[0xFF11] = 0xBF;   // NR11
-    memory[0xFF12] = 0xF3;   // NR12
-    memory[0xFF14] = 0xBF;   // NR14
-    memory[0xFF16] = 0x3F;   // NR21
-    memory[0xFF17] = 0x00;   // NR22
-    memory[0xFF19] = 0xBF;   // NR24
-    memory[0xFF1A] = 0x7F;   // NR30
-    memory[0xFF1B] = 0xFF;   // NR31
-    memory[0xFF1C] = 0x9F;   // NR32
-    memory[0xFF1E] = 0xBF;   // NR33
-    memory[0xFF20] = 0xFF;   // NR41
-    memory[0xFF21] = 0x00;   // NR42
-    memory[0xFF22] = 0x00;   // NR43
-    memory[0xFF23] = 0xBF;   // NR30
-    memory[0xFF24] = 0x77;   // NR50
-    memory[0xFF25] = 0xF3;   // NR51
-    memory[0xFF26] = 0xF1;   // NR52
-    memory[0xFF40] = 0x91;   // LCDC - LCD enabled, BG on
-    memory[0xFF42] = 0x00;   // SCY
-    memory[0xFF43] = 0x00;   // SCX
-    memory[0xFF44] = 0x00;   // LY
-    memory[0xFF45] = 0x00;   // LYC
-    memory[0xFF47] = 0xFC;   // BGP - Background palette
-    memory[0xFF48] = 0xFF;   // OBP0
-    memory[0xFF49] = 0xFF;   // OBP1
-    memory[0xFF4A] = 0x00;   // WY
-    memory[0xFF4B] = 0x00;   // WX
-    memory[0xFF0F] = 0x00;   // IF - Interrupt flags
-    memory[0xFFFF] = 0x00;   // IE - Interrupt Enable
+    // Post-boot register values, written through the IO handlers so every component sees them
+    write_byte(gb, 0xFF05, 0x00);   // TIMA
+    write_byte(gb, 0xFF06, 0x00);   // TMA
+    write_byte(gb, 0xFF07, 0x00);   // TAC
+    write_byte(gb, 0xFF10, 0x80);   // NR10
+    write_byte(gb, 0xFF11, 0xBF);   // NR11
+    write_byte(gb, 0xFF12, 0xF3);   // NR12
+    write_byte(gb, 0xFF14, 0xBF);   // NR14
+    write_byte(gb, 0xFF16, 0x3F);   // NR21
+    write_byte(gb, 0xFF17, 0x00);   // NR22
+    write_byte(gb, 0xFF19, 0xBF);   // NR24
+    write_byte(gb, 0xFF1A, 0x7F);   // NR30
+    write_byte(gb, 0xFF1B, 0xFF);   // NR31
+    write_byte(gb, 0xFF1C, 0x9F);   // NR32
+    write_byte(gb, 0xFF1E, 0xBF);   // NR33
+    write_byte(gb, 0xFF20, 0xFF);   // NR41
+    write_byte(gb, 0xFF21, 0x00);   // NR42
+    write_byte(gb, 0xFF22, 0x00);   // NR43
+    write_byte(gb, 0xFF23, 0xBF);   // NR30
+    write_byte(gb, 0xFF24, 0x77);   // NR50
+    write_byte(gb, 0xFF25, 0xF3);   // NR51
+    write_byte(gb, 0xFF26, 0xF1);   // NR52
+    write_byte(gb, 0xFF40, 0x91);   // LCDC - LCD enabled, BG on
+    write_byte(gb, 0xFF42, 0x00);   // SCY
+    write_byte(gb, 0xFF43, 0x00);   // SCX
+    write_byte(gb, 0xFF44, 0x00);   // LY
+    write_byte(gb, 0xFF45, 0x00);   // LYC
+    write_byte(gb, 0xFF47, 0xFC);   // BGP - Background palette
+    write_byte(gb, 0xFF48, 0xFF);   // OBP0
+    write_byte(gb, 0xFF49, 0xFF);   // OBP1
+    write_byte(gb, 0xFF4A, 0x00);   // WY
+    write_byte(gb, 0xFF4B, 0x00);   // WX
+    write_byte(gb, 0xFF0F, 0x00);   // IF - Interrupt flags
+    write_byte(gb, 0xFFFF, 0x00);   // IE - Interrupt Enable
 }
 
-void boot(CPU* cpu, Options* opts)
+void boot(GB* gb, Options* opts)
 {
     if (opts->boot_path != NULL)
     {
-        bootstrap(opts->boot_path);
+        bootstrap(gb, opts->boot_path);
         printf("Boot ROM enabled. First 16 bytes:\n");
         for (int i = 0; i < 16; i++) 
         {
-            printf("%02X ", read_byte(i));
+            printf("%02X ", read_byte(gb, i));
             if (i == 7) printf("\n");
         }
         printf("\n");
@@ -150,68 +226,112 @@ void boot(CPU* cpu, Options* opts)
     else
     {
         // No boot ROM - initialize hardware registers and jump to 0x0100
-        init_hardware_regs();
-        cpu->PC = 0x0100;
+        init_hardware_regs(gb);
+        gb->cpu.PC = 0x0100;
         printf("Skipping boot ROM, starting at 0x0100\n");
         printf("First 16 ROM bytes at 0x0100:\n");
         for (int i = 0; i < 16; i++) 
         {
-            printf("%02X ", read_byte(0x0100 + i));
+            printf("%02X ", read_byte(gb, 0x0100 + i));
             if (i == 7) printf("\n");
         }
         printf("\n");
     }
-    printf("Initial LCDC: 0x%02X\n", memory[0xFF40]);
-    printf("Initial SCX: %d, SCY: %d\n", memory[0xFF43], memory[0xFF42]);
-    printf("Initial BGP: 0x%02X\n", memory[0xFF47]);
+    printf("Initial LCDC: 0x%02X\n", gb->memory[0xFF40]);
+    printf("Initial SCX: %d, SCY: %d\n", gb->memory[0xFF43], gb->memory[0xFF42]);
+    printf("Initial BGP: 0x%02X\n", gb->memory[0xFF47]);
     printf("Starting PC: 0x%04X, SP: 0x%04X\n", REG_PC, REG_SP);
 }
 
-void load_game(Options* opts, char** args)
+void load_game(GB* gb, Options* opts)
 {
-    FILE* game_rom = fopen(opts->game_path, "rb");
-    if (!game_rom)
+    if (cartridge_load(&gb->cart, opts->game_path) != 0)
     {
-        fprintf(stderr, "Failed to open ROM file: %s\n", args[1]);
+        fprintf(stderr, "Failed to open ROM file: %s\n", opts->game_path);
         exit(EXIT_FAILURE);
     }
-    size_t game_size = fread(memory, 1, MEM_SIZE, game_rom);
-    fclose(game_rom);
-    printf("Game ROM loaded. (%zu bytes)\n", game_size);
+    gb->cart.save_on_disable = opts->save_on_disable;
+    printf("Game ROM loaded. (%zu bytes)\n", gb->cart.rom_size);
+}
+
+static double host_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Hashed as RGBA8888, so the value stays comparable with builds that kept RGBA frames
+static uint32_t framebuffer_hash(const PPU* ppu)
+{
+    // FNV-1a, only used to check that two builds emulate identically
+    uint32_t hash = 2166136261u;
+    uint32_t* rgba = malloc(144 * 160 * sizeof(uint32_t));
+    if (!rgba) return 0;
+    ppu_convert_frame(ppu, PIXELS_RGBA8888, rgba, 160 * sizeof(uint32_t));
+    const uint8_t* bytes = (const uint8_t*)rgba;
+    for (size_t i = 0; i < 144 * 160 * sizeof(uint32_t); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    free(rgba);
+    return hash;
 }
 
-void emu_loop(CPU* cpu, PPU* ppu, SDL_Context* context)
+static void print_bench(GB* gb, uint32_t frames, uint64_t instructions, uint64_t cycles, double seconds)
+{
+    if (seconds <= 0) seconds = 1e-9;
+    printf("\n=== Headless benchmark ===\n");
+    printf("Emulated frames: %u in %.3f s\n", frames, seconds);
+    printf("Frames/sec:      %.1f (%.2fx realtime)\n", frames / seconds, frames / seconds / 59.7275);
+    printf("Instructions/s:  %.2f M\n", instructions / seconds / 1e6);
+    printf("Cycles/sec:      %.2f M\n", cycles / seconds / 1e6);
+    printf("Idle skipped:    %llu cycles (%.1f%%)\n", (unsigned long long)gb->idle_skipped_cycles,
+           cycles ? 100.0 * gb->idle_skipped_cycles / cycles : 0.0);
+#ifdef JIT
+    printf("JIT:             %u blocks, %.1f%% of instructions native\n", gb->jit.stats.compiled,
+           instructions ? 100.0 * gb->jit.stats.instructions / instructions : 0.0);
+#endif
+    printf("Frame hash:      %08X\n", framebuffer_hash(&gb->ppu));
+    FLAGS_SYNC(gb);
+    print_cpu_state(&gb->cpu);
+}
+
+void emu_loop(GB* gb, Display* display, Options* opts)
 {
     int running = 1;
     int frame_count = 0;
-    SDL_Event event;
     uint16_t last_pc = REG_PC;
     int stuck_count = 0;
     int instruction_count = 0;
     int waiting_for_lcd = 0;
+    uint32_t emulated_frames = 0;
+    uint64_t total_instructions = 0;
+    uint64_t total_cycles = 0;
+    double start_time = host_seconds();
+    double last_save = start_time;
     
     while (running)
     {
-        while (SDL_PollEvent(&event))
-        {
-            if (event.type == SDL_QUIT) 
-                running = 0;
-            else if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)
-                handle_input(&event);
-        }
+        if (display && !display_poll(display, gb))
+            running = 0;
         
         int cycles = 0;
+        if (!debug)
+            cycles = cpu_run(gb, 70224, &total_instructions);
         while (cycles < 70224)
         {
             uint16_t pc_before = REG_PC;
             uint16_t sp_before = REG_SP;
-            uint8_t opcode = read_byte(REG_PC);
+            uint8_t opcode = read_byte(gb, REG_PC);
             
             if (dbg.dbg_cpu)
             {
                 // Debug first 50 instructions
                 if (instruction_count < 50)
                 {
+                    FLAGS_SYNC(gb);
                     DBG_PRINT("Inst %3d: PC=%04X SP=%04X opcode=%02X | AF=%04X BC=%04X DE=%04X HL=%04X\n",
                            instruction_count, pc_before, sp_before, opcode, 
                            REG_AF, REG_BC, REG_DE, REG_HL);
@@ -219,7 +339,8 @@ void emu_loop(CPU* cpu, PPU* ppu, SDL_Context* context)
                 }
             }
             
-            cycles += cpu_step(cpu, ppu);
+            cycles += cpu_step(gb);
+            total_instructions++;
             
             if (debug)
             {
@@ -228,8 +349,8 @@ void emu_loop(CPU* cpu, PPU* ppu, SDL_Context* context)
                 {
                     DBG_PRINT("\n*** CPU stuck at 0x009F - this is the LCD wait loop in boot ROM ***\n");
                     DBG_PRINT("Opcode: 0x%02X at 0x009F\n", opcode);
-                    DBG_PRINT("LCDC register (0xFF40): 0x%02X (bit 7 = LCD on/off)\n", memory[0xFF40]);
-                    DBG_PRINT("LY register (0xFF44): 0x%02X\n", memory[0xFF44]);
+                    DBG_PRINT("LCDC register (0xFF40): 0x%02X (bit 7 = LCD on/off)\n", gb->memory[0xFF40]);
+                    DBG_PRINT("LY register (0xFF44): 0x%02X\n", gb->memory[0xFF44]);
                     DBG_PRINT("This loop waits for LY to reach 144, but LCDC bit 7 is 0 (LCD off)\n");
                     DBG_PRINT("Boot ROM needs to turn on LCD first!\n");
                     waiting_for_lcd = 1;
@@ -243,15 +364,24 @@ void emu_loop(CPU* cpu, PPU* ppu, SDL_Context* context)
                            pc_before, sp_before, opcode);
                     DBG_PRINT("Stack at SP:\n");
                     for (int i = 0; i < 8; i++)
-                        DBG_PRINT("  [0x%04X] = 0x%02X\n", sp_before + i, read_byte(sp_before + i));
-                    print_cpu_state(cpu);
+                        DBG_PRINT("  [0x%04X] = 0x%02X\n", sp_before + i, read_byte(gb, sp_before + i));
+                    FLAGS_SYNC(gb);
+                    print_cpu_state(&gb->cpu);
                     running = 0;
                     break;
                 }
             }
         }
+        total_cycles += cycles;
+        emulated_frames++;
+
+        if (opts->save_interval && host_seconds() - last_save >= opts->save_interval)
+        {
+            cartridge_sync(&gb->cart, 0);
+            last_save = host_seconds();
+        }
         
-        if (ppu->frame_ready)
+        if (gb->ppu.frame_ready)
         {
             frame_count++;
             
@@ -262,15 +392,16 @@ void emu_loop(CPU* cpu, PPU* ppu, SDL_Context* context)
                 if (stuck_count > 300)
                 {
                     printf("\n!!! CPU appears stuck in infinite loop at PC=0x%04X !!!\n", REG_PC);
-                    printf("Opcode at PC: 0x%02X\n", read_byte(REG_PC));
+                    printf("Opcode at PC: 0x%02X\n", read_byte(gb, REG_PC));
                     printf("Nearby code:\n");
                     for (int i = -4; i <= 4; i++) 
                     {
                         printf("  [0x%04X] = 0x%02X%s\n", 
-                               REG_PC + i, read_byte(REG_PC + i),
+                               REG_PC + i, read_byte(gb, REG_PC + i),
                                i == 0 ? " <-- PC" : "");
                     }
-                    print_cpu_state(cpu);
+                    FLAGS_SYNC(gb);
+                    print_cpu_state(&gb->cpu);
                     running = 0;
                     break;
                 }
@@ -286,12 +417,45 @@ void emu_loop(CPU* cpu, PPU* ppu, SDL_Context* context)
                 if (frame_count % 60 == 0)
                 {
                     DBG_PRINT("Frame %d: PC=0x%04X SP=0x%04X LCDC=0x%02X BGP=0x%02X\n", 
-                           frame_count, REG_PC, REG_SP, memory[0xFF40], memory[0xFF47]);
+                           frame_count, REG_PC, REG_SP, gb->memory[0xFF40], gb->memory[0xFF47]);
                 }
             }
             
-            render_frame(context->renderer, context->texture, ppu->framebuffer);
-            ppu->frame_ready = 0;
+            gb->ppu.frame_ready = 0;
         }
+
+        if (opts->frames && emulated_frames >= opts->frames)
+            running = 0;
     }
+
+    if (opts->headless)
+        print_bench(gb, emulated_frames, total_instructions, total_cycles, host_seconds() - start_time);
+    if (opts->bench_ppu)
+        ppu_bench(gb, 2000);
+}
+
+// The cartridge goes in first so memory_init can point the ROM pages at it
+GB* gb_create(Options* opts)
+{
+    GB* gb = calloc(1, sizeof(GB));
+    if (!gb) return NULL;
+    load_game(gb, opts);
+    sched_init(&gb->sched);
+    memory_init(gb);
+    joypad_init(gb);
+    cpu_init(gb);
+    ppu_init(gb);
+    ppu_set_render_rate(gb, opts->video ? opts->frameskip + 1 : 0);
+    return gb;
+}
+
+void gb_destroy(GB* gb)
+{
+    if (!gb) return;
+    block_cache_free(gb);
+    cartridge_free(&gb->cart);
+#ifdef JIT
+    jit_free(gb);
+#endif
+    free(gb);
 }
@@ -2,11 +2,82 @@
 #define GB_H
 
 #include "../cpu/cpu.h"
+#include "../cpu/blocks.h"
+#include "../cpu/jit.h"
+#include "../memory/memory.h"
+#include "../memory/cartridge.h"
+#include "../io/ppu.h"
+#include "../io/timer.h"
+#include "../io/joypad.h"
+#include "scheduler.h"
 #include <SDL2/SDL.h>
 
+// One emulated Game Boy. All machine state lives here and is reached through the
+// GB* every component gets, so separate instances can run on separate threads.
+// Command line switches (debug output, --no-* toggles) stay process-wide.
+struct GB {
+    CPU cpu;            // first, so JIT code reaches the registers with 8-bit offsets
+    PageTable map;
+    Cartridge cart;
+    IoTable io;
+    Scheduler sched;
+    Timer timer;
+    Joypad joypad;
+    DMA dma;
+    PPU ppu;
+    BlockCache blocks;
+#ifdef JIT
+    JitState jit;
+#endif
+    // Last trip into an idle loop, to compare the next one against
+    struct {
+        const Block* block;
+        CPU cpu;
+        uint64_t time;
+        uint64_t deadline;
+    } idle_watch;
+    uint64_t idle_skipped_cycles;
+
+    uint8_t bootstrap_enabled;
+    uint8_t vram_block;
+    uint16_t current_pc_debug;
+    uint8_t boot_rom[256];
+    uint8_t memory[MEM_SIZE];
+};
+
+static inline void request_interrupt(GB* gb, Interrupt interrupt) { gb->memory[ADDR_IF] |= (1 << interrupt); }
+
+static inline uint8_t read_byte(GB* gb, uint16_t addr)
+{
+    const uint8_t* page = gb->map.read[addr >> 8];
+    if (page) return page[addr & 0xFF];
+    return memory_read(gb, addr);
+}
+
+// No side effects and no access checks, for looking at instruction bytes
+static inline uint8_t peek_byte(GB* gb, uint16_t addr)
+{
+    const uint8_t* page = gb->map.read[addr >> 8];
+    return page ? page[addr & 0xFF] : gb->memory[addr];
+}
+
+static inline void write_byte(GB* gb, uint16_t addr, uint8_t val)
+{
+    uint8_t* page = gb->map.write[addr >> 8];
+    if (page) page[addr & 0xFF] = val;
+    else memory_write(gb, addr, val);
+}
+
 typedef struct {
     char* game_path;
     char* boot_path;
+    uint8_t headless;   // run without SDL, print throughput at exit
+    uint32_t frames;    // stop after this many emulated frames (0 = run forever)
+    uint32_t save_interval;   // seconds between .sav syncs (0 = only on exit and RAM disable)
+    uint8_t save_on_disable;
+    uint8_t bench_ppu;  // time the scanline renderers on the final frame's VRAM
+    uint32_t frameskip; // frames skipped after each one drawn
+    uint8_t video;      // 0 = keep PPU timing but never draw
 } Options;
 
 typedef struct {
@@ -15,11 +86,15 @@ typedef struct {
     SDL_Texture* texture;
 } SDL_Context;
 
+typedef struct Display Display;
+
 Options parse_cli(int count, char** args);
 SDL_Context init_sdl();
-void sdl_cleanup(SDL_Context* context);
-void boot(CPU* cpu, Options* opts);
-void load_game(Options* opts, char** args);
-void emu_loop(CPU* cpu, PPU* ppu, SDL_Context* context);
+void cleanup_sdl(SDL_Context* context);
+GB* gb_create(Options* opts);
+void gb_destroy(GB* gb);
+void boot(GB* gb, Options* opts);
+void load_game(GB* gb, Options* opts);
+void emu_loop(GB* gb, Display* display, Options* opts);
 
 #endif
@@ -0,0 +1,102 @@
+#include "scheduler.h"
+#include <stdint.h>
+#include <string.h>
+
+static void heap_swap(Scheduler* sched, int a, int b)
+{
+    Event tmp = sched->heap[a];
+    sched->heap[a] = sched->heap[b];
+    sched->heap[b] = tmp;
+    sched->heap_pos[sched->heap[a].type] = a;
+    sched->heap_pos[sched->heap[b].type] = b;
+}
+
+static void sift_up(Scheduler* sched, int i)
+{
+    while (i > 0 && sched->heap[(i - 1) / 2].when > sched->heap[i].when)
+    {
+        heap_swap(sched, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void sift_down(Scheduler* sched, int i)
+{
+    for (;;)
+    {
+        int smallest = i;
+        int left = 2 * i + 1, right = 2 * i + 2;
+        if (left < sched->heap_size && sched->heap[left].when < sched->heap[smallest].when) smallest = left;
+        if (right < sched->heap_size && sched->heap[right].when < sched->heap[smallest].when) smallest = right;
+        if (smallest == i) return;
+        heap_swap(sched, i, smallest);
+        i = smallest;
+    }
+}
+
+static inline void update_deadline(Scheduler* sched)
+{
+    sched->deadline = sched->heap_size ? sched->heap[0].when : UINT64_MAX;
+}
+
+void sched_init(Scheduler* sched)
+{
+    memset(sched, 0, sizeof(Scheduler));
+    for (int i = 0; i < EVENT_COUNT; i++)
+        sched->heap_pos[i] = -1;
+    update_deadline(sched);
+}
+
+void sched_register(Scheduler* sched, EventType type, EventHandler handler, void* data)
+{
+    sched->handlers[type] = handler;
+    sched->handler_data[type] = data;
+}
+
+// Queues an event, or moves it if it is already queued
+void sched_add(Scheduler* sched, EventType type, uint64_t when)
+{
+    int i = sched->heap_pos[type];
+    if (i < 0)
+    {
+        i = sched->heap_size++;
+        sched->heap[i].type = type;
+        sched->heap_pos[type] = i;
+    }
+    sched->heap[i].when = when;
+    sift_up(sched, i);
+    sift_down(sched, sched->heap_pos[type]);
+    update_deadline(sched);
+}
+
+void sched_remove(Scheduler* sched, EventType type)
+{
+    int i = sched->heap_pos[type];
+    if (i < 0) return;
+    sched->heap_pos[type] = -1;
+    if (i != --sched->heap_size)
+    {
+        sched->heap[i] = sched->heap[sched->heap_size];
+        sched->heap_pos[sched->heap[i].type] = i;
+        sift_up(sched, i);
+        sift_down(sched, sched->heap_pos[sched->heap[i].type]);
+    }
+    update_deadline(sched);
+}
+
+// Runs a handler right away, to catch a component up before its registers are touched
+void sched_sync(Scheduler* sched, EventType type)
+{
+    if (sched->handlers[type]) sched->handlers[type](sched->handler_data[type]);
+}
+
+// Handlers are expected to queue their own next event
+void sched_dispatch(Scheduler* sched)
+{
+    while (sched->heap_size && sched->heap[0].when <= sched->now)
+    {
+        EventType type = sched->heap[0].type;
+        sched_remove(sched, type);
+        sched_sync(sched, type);
+    }
+}
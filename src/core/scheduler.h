@@ -0,0 +1,43 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+// Components no longer tick after every instruction. Each one keeps the time it
+// was last brought up to date, puts its next interesting moment in the queue, and
+// catches up when that moment passes or when the CPU touches its registers.
+typedef enum { EVENT_PPU, EVENT_TIMER, EVENT_DMA, EVENT_SERIAL, EVENT_JOYPAD, EVENT_COUNT } EventType;
+
+typedef void (*EventHandler)(void* data);
+
+typedef struct {
+    uint64_t when;
+    EventType type;
+} Event;
+
+typedef struct {
+    uint64_t now;        // cycles since power on, advanced after each instruction
+    uint64_t deadline;   // earliest queued event
+    // Binary min-heap on time, one slot per event type
+    Event heap[EVENT_COUNT];
+    int heap_size;
+    int heap_pos[EVENT_COUNT];  // -1 when not queued
+    EventHandler handlers[EVENT_COUNT];
+    void* handler_data[EVENT_COUNT];
+} Scheduler;
+
+void sched_init(Scheduler* sched);
+void sched_register(Scheduler* sched, EventType type, EventHandler handler, void* data);
+void sched_add(Scheduler* sched, EventType type, uint64_t when);
+void sched_remove(Scheduler* sched, EventType type);
+void sched_sync(Scheduler* sched, EventType type);
+void sched_dispatch(Scheduler* sched);
+
+static inline void sched_advance(Scheduler* sched, uint32_t cycles)
+{
+    sched->now += cycles;
+    if (sched->now >= sched->deadline)
+        sched_dispatch(sched);
+}
+
+#endif
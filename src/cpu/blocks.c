@@ -0,0 +1,406 @@
+#include "blocks.h"
+#include "cpu.h"
+#include "instructions.h"
+#include "opcodes.h"
+#include "../memory/memory.h"
+#include "../core/gb.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+uint8_t block_cache_enabled = 1;
+
+// Instruction lengths as the interpreter consumes them (STOP only takes one byte here)
+static const uint8_t op_length[256] = {
+//  0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F
+    1, 3, 1, 1, 1, 1, 2, 1, 3, 1, 1, 1, 1, 1, 2, 1, // 0
+    1, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1, // 1
+    2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1, // 2
+    2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1, // 3
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 4
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 5
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 6
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 7
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 8
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 9
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // A
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // B
+    1, 1, 3, 3, 3, 1, 2, 1, 1, 1, 3, 2, 3, 3, 2, 1, // C
+    1, 1, 3, 1, 3, 1, 2, 1, 1, 1, 3, 1, 3, 1, 2, 1, // D
+    2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1, // E
+    2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1, // F
+};
+
+static uint8_t* reg8(GB* gb, uint8_t index)
+{
+    switch (index)
+    {
+        case 0: return &REG_B;
+        case 1: return &REG_C;
+        case 2: return &REG_D;
+        case 3: return &REG_E;
+        case 4: return &REG_H;
+        case 5: return &REG_L;
+        case 7: return &REG_A;
+    }
+    return NULL; // (HL)
+}
+
+static uint16_t* reg16(GB* gb, uint8_t index)
+{
+    switch (index)
+    {
+        case 0: return &REG_BC;
+        case 1: return &REG_DE;
+        case 2: return &REG_HL;
+    }
+    return &REG_SP;
+}
+
+static inline int condition_met(GB* gb, uint8_t cond)
+{
+    FLAGS_SYNC(gb);
+    switch (cond)
+    {
+        case NZ: return !(REG_F & FLAG_Z);
+        case Z: return (REG_F & FLAG_Z) != 0;
+        case NC: return !(REG_F & FLAG_C);
+        default: return (REG_F & FLAG_C) != 0;
+    }
+}
+
+// Decoded handlers. PC already points past the instruction when these run.
+static uint8_t d_generic(GB* gb, const DecodedOp* op)
+{
+    REG_PC = op->next_pc - op->length + 1;
+    return opcodes[op->opcode](gb);
+}
+
+static uint8_t d_ld_r_r(GB* gb, const DecodedOp* op) { (void)gb; *op->dst = *op->src; return 4; }
+static uint8_t d_ld_r_n(GB* gb, const DecodedOp* op) { (void)gb; *op->dst = (uint8_t)op->imm; return 8; }
+static uint8_t d_ld_rr_nn(GB* gb, const DecodedOp* op) { (void)gb; *op->pair = op->imm; return 12; }
+static uint8_t d_ldh_n_a(GB* gb, const DecodedOp* op) { write_byte(gb, op->imm, REG_A); return 12; }
+static uint8_t d_ldh_a_n(GB* gb, const DecodedOp* op) { REG_A = read_byte(gb, op->imm); return 12; }
+static uint8_t d_ld_nn_a(GB* gb, const DecodedOp* op) { write_byte(gb, op->imm, REG_A); return 16; }
+static uint8_t d_ld_a_nn(GB* gb, const DecodedOp* op) { REG_A = read_byte(gb, op->imm); return 16; }
+
+static uint8_t d_add_r(GB* gb, const DecodedOp* op) { add_a_n(gb, *op->src); return 4; }
+static uint8_t d_adc_r(GB* gb, const DecodedOp* op) { adc_a_n(gb, *op->src); return 4; }
+static uint8_t d_sub_r(GB* gb, const DecodedOp* op) { sub_a_n(gb, *op->src); return 4; }
+static uint8_t d_sbc_r(GB* gb, const DecodedOp* op) { sbc_a_n(gb, *op->src); return 4; }
+static uint8_t d_and_r(GB* gb, const DecodedOp* op) { and_a_n(gb, *op->src); return 4; }
+static uint8_t d_xor_r(GB* gb, const DecodedOp* op) { xor_a_n(gb, *op->src); return 4; }
+static uint8_t d_or_r(GB* gb, const DecodedOp* op) { or_a_n(gb, *op->src); return 4; }
+static uint8_t d_cp_r(GB* gb, const DecodedOp* op) { cp_a_n(gb, *op->src); return 4; }
+
+static uint8_t d_add_n(GB* gb, const DecodedOp* op) { add_a_n(gb, (uint8_t)op->imm); return 8; }
+static uint8_t d_adc_n(GB* gb, const DecodedOp* op) { adc_a_n(gb, (uint8_t)op->imm); return 8; }
+static uint8_t d_sub_n(GB* gb, const DecodedOp* op) { sub_a_n(gb, (uint8_t)op->imm); return 8; }
+static uint8_t d_sbc_n(GB* gb, const DecodedOp* op) { sbc_a_n(gb, (uint8_t)op->imm); return 8; }
+static uint8_t d_and_n(GB* gb, const DecodedOp* op) { and_a_n(gb, (uint8_t)op->imm); return 8; }
+static uint8_t d_xor_n(GB* gb, const DecodedOp* op) { xor_a_n(gb, (uint8_t)op->imm); return 8; }
+static uint8_t d_or_n(GB* gb, const DecodedOp* op) { or_a_n(gb, (uint8_t)op->imm); return 8; }
+static uint8_t d_cp_n(GB* gb, const DecodedOp* op) { cp_a_n(gb, (uint8_t)op->imm); return 8; }
+
+static uint8_t d_inc_r(GB* gb, const DecodedOp* op) { inc_n(gb, op->dst); return 4; }
+static uint8_t d_dec_r(GB* gb, const DecodedOp* op) { dec_n(gb, op->dst); return 4; }
+static uint8_t d_inc_rr(GB* gb, const DecodedOp* op) { inc_nn(gb, op->pair); return 8; }
+static uint8_t d_dec_rr(GB* gb, const DecodedOp* op) { dec_nn(gb, op->pair); return 8; }
+
+static uint8_t d_cb(GB* gb, const DecodedOp* op) { return cb_opcodes[op->imm](gb); }
+
+static uint8_t d_jr(GB* gb, const DecodedOp* op) { REG_PC = op->imm; return 12; }
+static uint8_t d_jp(GB* gb, const DecodedOp* op) { REG_PC = op->imm; return 16; }
+static uint8_t d_call(GB* gb, const DecodedOp* op)
+{
+    push_nn(gb, REG_PC);
+    REG_PC = op->imm;
+    return 24;
+}
+static uint8_t d_jr_cc(GB* gb, const DecodedOp* op)
+{
+    if (!condition_met(gb, op->cond)) return 8;
+    REG_PC = op->imm;
+    return 12;
+}
+static uint8_t d_jp_cc(GB* gb, const DecodedOp* op)
+{
+    if (!condition_met(gb, op->cond)) return 12;
+    REG_PC = op->imm;
+    return 16;
+}
+static uint8_t d_call_cc(GB* gb, const DecodedOp* op)
+{
+    if (!condition_met(gb, op->cond)) return 12;
+    push_nn(gb, REG_PC);
+    REG_PC = op->imm;
+    return 24;
+}
+
+static const DecodedFn alu_r[8] = { d_add_r, d_adc_r, d_sub_r, d_sbc_r, d_and_r, d_xor_r, d_or_r, d_cp_r };
+static const DecodedFn alu_n[8] = { d_add_n, d_adc_n, d_sub_n, d_sbc_n, d_and_n, d_xor_n, d_or_n, d_cp_n };
+
+// Branches, HALT/STOP and anything touching IME end a block
+static int ends_block(uint8_t opcode)
+{
+    switch (opcode)
+    {
+        case 0x10: case 0x76: case 0xF3: case 0xFB:
+        case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+        case 0xC2: case 0xC3: case 0xCA: case 0xD2: case 0xDA: case 0xE9:
+        case 0xC4: case 0xCC: case 0xCD: case 0xD4: case 0xDC:
+        case 0xC0: case 0xC8: case 0xC9: case 0xD0: case 0xD8: case 0xD9:
+            return 1;
+    }
+    return (opcode & 0xC7) == 0xC7; // RST
+}
+
+// Code is only cached where reading it has no side effects:
+// ROM (outside the boot ROM overlay), WRAM and HRAM
+static int region_limit(GB* gb, uint16_t pc)
+{
+    if (pc < 0x4000) return (gb->bootstrap_enabled && pc < 0x0100) ? 0 : 0x4000;
+    if (pc < 0x8000) return 0x8000;
+    if (pc >= WRAM_START && pc <= WRAM_END) return (pc | 0xFF) + 1; // one page per RAM block
+    if (pc >= HRAM_START && pc <= HRAM_END) return HRAM_END + 1;
+    return 0;
+}
+
+// ROM blocks are cached per bank, so switching banks back and forth keeps them
+static inline uint32_t block_key(GB* gb, uint16_t pc)
+{
+    uint32_t bank = 0;
+    if (pc < ROMX_START) bank = gb->cart.rom_bank0;
+    else if (pc < VRAM_START) bank = gb->cart.rom_bank;
+    return (bank << 16) | pc;
+}
+
+static inline uint32_t block_hash(uint32_t key) { return (key ^ (key >> 10)) & (BLOCK_HASH_SIZE - 1); }
+
+static void decode(GB* gb, DecodedOp* op, uint16_t pc)
+{
+    uint8_t opcode = peek_byte(gb, pc);
+    uint8_t length = op_length[opcode];
+    uint16_t imm = 0;
+    if (length == 2) imm = peek_byte(gb, pc + 1);
+    if (length == 3) imm = peek_byte(gb, pc + 1) | (peek_byte(gb, pc + 2) << 8);
+
+    memset(op, 0, sizeof(DecodedOp));
+    op->opcode = opcode;
+    op->length = length;
+    op->next_pc = pc + length;
+    op->imm = imm;
+    op->fn = d_generic;
+
+    uint8_t x = opcode >> 6, y = (opcode >> 3) & 7, z = opcode & 7;
+    if (x == 1 && opcode != 0x76 && y != 6 && z != 6)
+    {
+        op->fn = d_ld_r_r;
+        op->dst = reg8(gb, y);
+        op->src = reg8(gb, z);
+    }
+    else if (x == 2 && z != 6)
+    {
+        op->fn = alu_r[y];
+        op->src = reg8(gb, z);
+    }
+    else if (x == 3 && z == 6)
+    {
+        op->fn = alu_n[y];
+    }
+    else if (x == 0 && y != 6 && (z == 4 || z == 5 || z == 6))
+    {
+        op->fn = z == 4 ? d_inc_r : z == 5 ? d_dec_r : d_ld_r_n;
+        op->dst = reg8(gb, y);
+    }
+    else if (x == 0 && (z == 1 || z == 3) && !(y & 1))
+    {
+        op->fn = z == 1 ? d_ld_rr_nn : d_inc_rr;
+        op->pair = reg16(gb, y >> 1);
+    }
+    else if (x == 0 && z == 3)
+    {
+        op->fn = d_dec_rr;
+        op->pair = reg16(gb, y >> 1);
+    }
+    else switch (opcode)
+    {
+        case 0xE0: op->fn = d_ldh_n_a; op->imm = 0xFF00 + imm; break;
+        case 0xF0: op->fn = d_ldh_a_n; op->imm = 0xFF00 + imm; break;
+        case 0xEA: op->fn = d_ld_nn_a; break;
+        case 0xFA: op->fn = d_ld_a_nn; break;
+        case 0xCB: op->fn = d_cb; break;
+        case 0x18: op->fn = d_jr; op->imm = op->next_pc + (int8_t)imm; break;
+        case 0x20: case 0x28: case 0x30: case 0x38:
+            op->fn = d_jr_cc;
+            op->cond = y - 4;
+            op->imm = op->next_pc + (int8_t)imm;
+            break;
+        case 0xC3: op->fn = d_jp; break;
+        case 0xC2: case 0xCA: case 0xD2: case 0xDA: op->fn = d_jp_cc; op->cond = y; break;
+        case 0xCD: op->fn = d_call; break;
+        case 0xC4: case 0xCC: case 0xD4: case 0xDC: op->fn = d_call_cc; op->cond = y; break;
+    }
+}
+
+// DIV and TIMA are the only reads that change without a scheduled event
+static inline int idle_safe_read(uint16_t addr) { return addr != ADDR_DIV && addr != ADDR_TIMA; }
+
+// Polling loops: the block ends with a branch back to its own start and in between
+// only works on registers and reads memory
+static void mark_idle_loop(Block* block)
+{
+    block->idle_loop = 0;
+    block->idle_reads = 0;
+
+    const DecodedOp* last = &block->ops[block->count - 1];
+    int conditional = last->fn == d_jr_cc || last->fn == d_jp_cc;
+    if (!conditional && last->fn != d_jr && last->fn != d_jp) return;
+    if (last->imm != block->start) return;
+
+    for (int i = 0; i < block->count - 1; i++)
+    {
+        const DecodedOp* op = &block->ops[i];
+        uint8_t opcode = op->opcode;
+        uint8_t x = opcode >> 6, y = (opcode >> 3) & 7, z = opcode & 7;
+
+        if (op->fn == d_ldh_a_n || op->fn == d_ld_a_nn)
+        {
+            if (!idle_safe_read(op->imm)) return;
+            continue;
+        }
+        if (op->fn == d_ldh_n_a || op->fn == d_ld_nn_a) return;
+        if (op->fn == d_cb)
+        {
+            if ((op->imm & 7) != 6) continue;
+            if (op->imm < 0x40 || op->imm >= 0x80) return; // only BIT b,(HL) leaves memory alone
+            block->idle_reads |= IDLE_READS_HL;
+            continue;
+        }
+        if (op->fn != d_generic) continue;
+
+        if ((x == 1 && z == 6 && y != 6) || (x == 2 && z == 6))  // LD r,(HL) / ALU A,(HL)
+        {
+            block->idle_reads |= IDLE_READS_HL;
+            continue;
+        }
+        switch (opcode)
+        {
+            case 0x0A: block->idle_reads |= IDLE_READS_BC; continue;
+            case 0x1A: block->idle_reads |= IDLE_READS_DE; continue;
+            case 0x00: case 0x07: case 0x0F: case 0x17: case 0x1F:
+            case 0x27: case 0x2F: case 0x37: case 0x3F:
+            case 0x09: case 0x19: case 0x29: case 0x39: case 0xF9:
+                continue;
+        }
+        return;
+    }
+
+    block->idle_loop = 1;
+    block->loop_cycles = block->cycles + (conditional ? 4 : 0);  // closing branch taken
+}
+
+void block_cache_flush(GB* gb)
+{
+    BlockCache* cache = &gb->blocks;
+    memset(cache->buckets, 0, sizeof(cache->buckets));
+    memset(cache->page_blocks, 0, sizeof(cache->page_blocks));
+    memset(cache->code_pages, 0, sizeof(cache->code_pages));
+    for (uint32_t i = 0; i < cache->arena_used; i++)
+        cache->arena[i].valid = 0;
+    cache->arena_used = 0;
+    memory_remap(gb, VRAM_START >> 8, 0xFF);
+}
+
+void block_cache_free(GB* gb)
+{
+    free(gb->blocks.arena);
+    gb->blocks.arena = NULL;
+    gb->blocks.arena_used = 0;
+}
+
+static Block* compile_block(GB* gb, uint16_t pc, uint32_t key)
+{
+    int limit = region_limit(gb, pc);
+    if (!limit || pc + op_length[peek_byte(gb, pc)] > limit) return NULL;
+
+    BlockCache* cache = &gb->blocks;
+    if (!cache->arena)
+    {
+        cache->arena = malloc(BLOCK_CACHE_SIZE * sizeof(Block));
+        if (!cache->arena) return NULL;
+    }
+    if (cache->arena_used == BLOCK_CACHE_SIZE) block_cache_flush(gb);
+
+    Block* block = &cache->arena[cache->arena_used++];
+    block->key = key;
+    block->start = pc;
+    block->cycles = 0;
+    block->count = 0;
+    block->valid = 1;
+#ifdef JIT
+    block->native = NULL;
+    block->hits = 0;
+#endif
+
+    uint16_t addr = pc;
+    while (block->count < BLOCK_MAX_OPS && addr + op_length[peek_byte(gb, addr)] <= limit)
+    {
+        DecodedOp* op = &block->ops[block->count++];
+        decode(gb, op, addr);
+        addr = op->next_pc;
+        uint8_t cycles = op->opcode == 0xCB ? cb_opcode_cycles[op->imm] : opcode_cycles[op->opcode];
+        block->cycles += cycles ? cycles : 4; // illegal opcodes run as nops
+        if (ends_block(op->opcode)) break;
+    }
+    block->end = addr;
+    mark_idle_loop(block);
+
+    uint32_t h = block_hash(key);
+    block->hash_next = cache->buckets[h];
+    cache->buckets[h] = block;
+
+    // ROM can't change under us, RAM blocks have to be dropped when written
+    block->page_next = NULL;
+    if (pc >= 0x8000)
+    {
+        uint8_t page = pc >> 8;
+        block->page_next = cache->page_blocks[page];
+        cache->page_blocks[page] = block;
+        // The first block on a page sends its writes through memory_write
+        if (cache->code_pages[page]++ == 0) memory_remap(gb, page, page);
+    }
+    return block;
+}
+
+Block* block_lookup(GB* gb, uint16_t pc)
+{
+    uint32_t key = block_key(gb, pc);
+    for (Block* block = gb->blocks.buckets[block_hash(key)]; block; block = block->hash_next)
+        if (block->key == key) return block;
+    return compile_block(gb, pc, key);
+}
+
+void block_invalidate(GB* gb, uint16_t addr)
+{
+    BlockCache* cache = &gb->blocks;
+    uint8_t page = addr >> 8;
+    Block** link = &cache->page_blocks[page];
+    while (*link)
+    {
+        Block* block = *link;
+        if (addr < block->start || addr >= block->end)
+        {
+            link = &block->page_next;
+            continue;
+        }
+
+        block->valid = 0;
+        *link = block->page_next;
+        if (--cache->code_pages[page] == 0) memory_remap(gb, page, page);
+
+        Block** bucket = &cache->buckets[block_hash(block->key)];
+        while (*bucket != block) bucket = &(*bucket)->hash_next;
+        *bucket = block->hash_next;
+    }
+}
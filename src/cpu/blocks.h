@@ -0,0 +1,67 @@
+#ifndef BLOCKS_H
+#define BLOCKS_H
+
+#include <stdint.h>
+#include "cpu.h"
+
+#define BLOCK_MAX_OPS 32
+#define BLOCK_CACHE_SIZE 2048
+#define BLOCK_HASH_SIZE 1024
+
+// Registers an idle loop reads memory through
+#define IDLE_READS_HL 0x01
+#define IDLE_READS_BC 0x02
+#define IDLE_READS_DE 0x04
+
+typedef struct DecodedOp DecodedOp;
+typedef uint8_t (*DecodedFn)(GB* gb, const DecodedOp* op); // returns cycles taken
+
+// One predecoded instruction. Operand pointers point into the GB the block was built for.
+struct DecodedOp {
+    DecodedFn fn;
+    uint8_t* dst;
+    uint8_t* src;
+    uint16_t* pair;
+    uint16_t imm;       // immediate, CB opcode or branch target
+    uint16_t next_pc;   // address of the following instruction
+    uint8_t opcode;
+    uint8_t length;
+    uint8_t cond;
+};
+
+// Straight-line code starting at one address, ending at the first branch,
+// HALT/STOP or EI/DI.
+typedef struct Block {
+    struct Block* hash_next;
+    struct Block* page_next;   // RAM blocks only, for invalidation on writes
+    uint32_t key;              // bank << 16 | start address
+    uint16_t start, end;       // code covers [start, end)
+    uint16_t cycles;           // cycles for a straight run (branches not taken)
+    uint8_t count;
+    uint8_t valid;
+    uint8_t idle_loop;         // branches to itself, reads only, no writes
+    uint8_t idle_reads;
+    uint16_t loop_cycles;      // one trip round an idle loop
+#ifdef JIT
+    struct JitCode* native;
+    uint16_t hits;
+#endif
+    DecodedOp ops[BLOCK_MAX_OPS];
+} Block;
+
+typedef struct {
+    Block* arena;
+    uint32_t arena_used;
+    Block* buckets[BLOCK_HASH_SIZE];
+    Block* page_blocks[256];
+    uint16_t code_pages[256];   // number of RAM blocks in each 256-byte page
+} BlockCache;
+
+extern uint8_t block_cache_enabled;
+
+Block* block_lookup(GB* gb, uint16_t pc);
+void block_invalidate(GB* gb, uint16_t addr);
+void block_cache_flush(GB* gb);
+void block_cache_free(GB* gb);
+
+#endif
@@ -1,94 +1,68 @@
 #include "cpu.h"
-#include "../io/ppu.h"
 #include "instructions.h"
 #include "opcodes.h"
-#include "../memory/memory.h"
+#include "../core/gb.h"
 #include "../debug/debug.h"
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
-Timer cpu_timer;
+uint8_t idle_skip_enabled = 1;
 
-void print_cpu_state(CPU* cpu)
+// Takes a bare CPU so copies (JIT verification) can be printed too. Flags have to
+// be materialised by the caller in LAZY_FLAGS builds.
+void print_cpu_state(const CPU* cpu)
 {
     printf("AF=%04X BC=%04X DE=%04X HL=%04X SP=%04X PC=%04X IME=%d \n",
-           REG_AF, REG_BC, REG_DE, REG_HL, REG_SP, REG_PC, cpu->IME);
+           cpu->af.AF, cpu->bc.BC, cpu->de.DE, cpu->hl.HL, cpu->SP, cpu->PC, cpu->IME);
 }
 
-static void handle_interrupt(CPU* cpu)
+static void handle_interrupt(GB* gb)
 {
-    uint8_t enabled = memory[ADDR_IF] & memory[ADDR_IE];
+    uint8_t enabled = gb->memory[ADDR_IF] & gb->memory[ADDR_IE];
     if (!enabled) return;
-    cpu->IME = 0;
-    push_nn(cpu, REG_PC);
+    gb->cpu.IME = 0;
+    push_nn(gb, REG_PC);
     if (enabled & (1 << 0)) 
     {
-        memory[ADDR_IF] &= ~(1 << 0);
+        gb->memory[ADDR_IF] &= ~(1 << 0);
         REG_PC = 0x40;
     } else if (enabled & (1 << 1)) 
     {
-        memory[ADDR_IF] &= ~(1 << 1);
+        gb->memory[ADDR_IF] &= ~(1 << 1);
         REG_PC = 0x48;
     } else if (enabled & (1 << 2)) 
     {
-        memory[ADDR_IF] &= ~(1 << 2);
+        gb->memory[ADDR_IF] &= ~(1 << 2);
         REG_PC = 0x50;
     } else if (enabled & (1 << 3))
     {
-        memory[ADDR_IF] &= ~(1 << 3);
+        gb->memory[ADDR_IF] &= ~(1 << 3);
         REG_PC = 0x58;
     } else if (enabled & (1 << 4)) 
     {
-        memory[ADDR_IF] &= ~(1 << 4);
+        gb->memory[ADDR_IF] &= ~(1 << 4);
         REG_PC = 0x60;
     }
 }
 
-static void timer_tick(int cycles)
+static inline void update_ime(GB* gb)
 {
-    cpu_timer.div_counter += cycles;
-    while (cpu_timer.div_counter >= 256) 
+    if (gb->cpu.pending_enable_interrupts) 
     {
-        cpu_timer.div_counter -= 256;
-        memory[ADDR_DIV]++;
+        gb->cpu.IME = 1;
+        gb->cpu.pending_enable_interrupts = 0;
     }
-
-    if (cpu_timer.overflow) 
+    if (gb->cpu.pending_disable_interrupts) 
     {
-        cpu_timer.delay -= cycles;
-        if (cpu_timer.delay <= 0) 
-        {
-            memory[ADDR_TIMA] = memory[ADDR_TMA];
-            cpu_timer.overflow = 0;
-        }
-    }
-
-    if (!(memory[ADDR_TAC] & 0x04)) return;
-
-    static const int tac_cycles[4] = {1024, 16, 64, 256};
-    uint8_t freq = memory[ADDR_TAC] & 0x03;
-    int step = tac_cycles[freq];
-    cpu_timer.tima_counter += cycles;
-
-    while (cpu_timer.tima_counter >= step) 
-    {
-        cpu_timer.tima_counter -= step;
-        if (memory[ADDR_TIMA] == 0xFF) 
-        {
-            memory[ADDR_TIMA] = 0x00;            
-            request_interrupt(TIMER_INT);
-            cpu_timer.overflow = 1;       
-            cpu_timer.delay = 4;        
-        } else 
-        {
-            memory[ADDR_TIMA]++;
-        }
+        gb->cpu.IME = 0;
+        gb->cpu.pending_disable_interrupts = 0;
     }
 }
 
-void cpu_init(CPU* cpu)
+void cpu_init(GB* gb)
 {
-    memset(cpu, 0, sizeof(CPU));
+    memset(&gb->cpu, 0, sizeof(CPU));
     REG_AF = 0x01B0;
     REG_BC = 0x0013;
     REG_DE = 0x00D8;
@@ -96,129 +70,291 @@ void cpu_init(CPU* cpu)
     REG_SP = 0xFFFE;
     REG_PC = 0x0000;
 
-    cpu->IME = 0;
-    cpu->halted = 0;
-    cpu->stopped = 0;
-    cpu->halt_bug = 0;
-    cpu->pending_enable_interrupts = 0;
-    cpu->pending_disable_interrupts = 0;
-
-    cpu_timer.cycle_counter = 0;
-    memory[ADDR_DIV] = 0;
-    memory[ADDR_TIMA] = 0;
-    memory[ADDR_TMA] = 0;
-    memory[ADDR_TAC] = 0;
+    gb->cpu.IME = 0;
+    gb->cpu.halted = 0;
+    gb->cpu.stopped = 0;
+    gb->cpu.halt_bug = 0;
+    gb->cpu.pending_enable_interrupts = 0;
+    gb->cpu.pending_disable_interrupts = 0;
+
+    timer_init(gb);
+    gb->memory[ADDR_DIV] = 0;
+    gb->memory[ADDR_TIMA] = 0;
+    gb->memory[ADDR_TMA] = 0;
+    gb->memory[ADDR_TAC] = 0;
+}
+
+// While halted only a scheduled event can raise IF, so jump straight to the next
+// deadline instead of ticking one cycle at a time. STOP freezes everything and
+// just uses up the budget.
+static uint32_t skip_idle(GB* gb, uint32_t limit)
+{
+    if (gb->cpu.stopped) return limit;
+
+    uint64_t cycles = gb->sched.deadline - gb->sched.now;
+    if (cycles > limit) cycles = limit;
+    if (!cycles) cycles = 1;
+    sched_advance(&gb->sched, cycles);
+    if (gb->memory[ADDR_IF] & gb->memory[ADDR_IE])
+        gb->cpu.halted = 0;
+    return cycles;
 }
 
-uint16_t cpu_step(CPU* cpu, PPU* ppu)
+uint16_t cpu_step(GB* gb)
 {
     if (dbg.dbg_boot)
     {
-        if (cpu->PC >= 0x0098 && cpu->PC <= 0x00A2) 
+        if (gb->cpu.PC >= 0x0098 && gb->cpu.PC <= 0x00A2) 
         {
+            FLAGS_SYNC(gb);
             DBG_PRINT("BOOT: PC=%04X op=%02X B=%02X F=%02X (Z=%d,C=%d,H=%d,N=%d)\n",
-                   cpu->PC, read_byte(cpu->PC), cpu->bc.B, cpu->af.F,
-                   (cpu->af.F & FLAG_Z) ? 1 : 0,
-                   (cpu->af.F & FLAG_C) ? 1 : 0, 
-                   (cpu->af.F & FLAG_H) ? 1 : 0,
-                   (cpu->af.F & FLAG_N) ? 1 : 0);
+                   gb->cpu.PC, read_byte(gb, gb->cpu.PC), gb->cpu.bc.B, gb->cpu.af.F,
+                   (gb->cpu.af.F & FLAG_Z) ? 1 : 0,
+                   (gb->cpu.af.F & FLAG_C) ? 1 : 0, 
+                   (gb->cpu.af.F & FLAG_H) ? 1 : 0,
+                   (gb->cpu.af.F & FLAG_N) ? 1 : 0);
         }
-        current_pc_debug = REG_PC;
-        if (cpu->PC >= 0x0090 && cpu->PC <= 0x00B0) 
+        gb->current_pc_debug = REG_PC;
+        if (gb->cpu.PC >= 0x0090 && gb->cpu.PC <= 0x00B0) 
         {
             DBG_PRINT("BOOT ROM: PC=%04X opcode=%02X LCDC=%02X LY=%02X\n", 
-                   cpu->PC, read_byte(cpu->PC), memory[0xFF40], memory[0xFF44]);
+                   gb->cpu.PC, read_byte(gb, gb->cpu.PC), gb->memory[0xFF40], gb->memory[0xFF44]);
         }
     }
 
-    if (cpu->halted)
-    {
-        timer_tick(1);
-        ppu_step(ppu, 1);
-        if (memory[ADDR_IF] & memory[ADDR_IE])
-            cpu->halted = 0;
-        return 1;
-    }
+    if (gb->cpu.halted || gb->cpu.stopped)
+        return skip_idle(gb, UINT16_MAX);
 
-    if (cpu->stopped) return 1;
-
-    uint8_t exec_twice = cpu->halt_bug;
-    if (cpu->halt_bug) cpu->halt_bug = 0;
-    uint8_t opcode = read_byte(REG_PC++);
-    uint16_t cycles;
+    uint8_t exec_twice = gb->cpu.halt_bug;
+    if (gb->cpu.halt_bug) gb->cpu.halt_bug = 0;
+    uint16_t cycles = opcodes[read_byte(gb, REG_PC++)](gb);
+    update_ime(gb);
 
-    if (opcode == 0xCB)
+    if (exec_twice)
     {
-        uint8_t cb_opcode = read_byte(REG_PC++);
-        cb_opcodes[cb_opcode](cpu);
-        cycles = cb_opcode_cycles[cb_opcode];
+        REG_PC--;
+        return cpu_step(gb);
     }
-    else 
+
+    sched_advance(&gb->sched, cycles);
+    if (dbg.dbg_boot)
     {
-        if (opcode == 0xC2 || opcode == 0xCA || opcode == 0xD2 || opcode == 0xDA)
-        {
-            Condition cond = (opcode == 0xC2) ? NZ : (opcode == 0xCA) ? Z : 
-                            (opcode == 0xD2) ? NC : C;
-            cycles = jp_cc_nn(cpu, cond);
-        }
-        else if (opcode == 0x20 || opcode == 0x28 || opcode == 0x30 || opcode == 0x38)
-        {
-            Condition cond = (opcode == 0x20) ? NZ : (opcode == 0x28) ? Z : 
-                            (opcode == 0x30) ? NC : C;
-            cycles = jr_cc_n(cpu, cond);
-        }
-        else if (opcode == 0xC4 || opcode == 0xCC || opcode == 0xD4 || opcode == 0xDC)
+        if (REG_PC >= 0x0090 && REG_PC <= 0x00A0) 
         {
-            Condition cond = (opcode == 0xC4) ? NZ : (opcode == 0xCC) ? Z : 
-                            (opcode == 0xD4) ? NC : C;
-            cycles = call_cc_nn(cpu, cond);
+            DBG_PRINT("Boot ROM LCD sequence: PC=%04X LCDC=%02X LY=%02X\n", 
+                   REG_PC, gb->memory[0xFF40], gb->memory[0xFF44]);
         }
-        else if (opcode == 0xC0 || opcode == 0xC8 || opcode == 0xD0 || opcode == 0xD8)
+    }
+    if (gb->cpu.IME && (gb->memory[ADDR_IF] & gb->memory[ADDR_IE]))
+        handle_interrupt(gb);
+    return cycles;
+}
+
+#ifdef JIT
+static uint32_t run_native(GB* gb, const JitCode* code, uint64_t* instructions)
+{
+    CPU before = gb->cpu;
+    uint32_t cycles = code->fn(gb);
+    if (jit_verify) jit_check(gb, code, &before, cycles);
+
+    sched_advance(&gb->sched, cycles);
+    *instructions += code->count;
+    gb->jit.stats.instructions += code->count;
+    if (gb->cpu.IME && (gb->memory[ADDR_IF] & gb->memory[ADDR_IE]))
+        handle_interrupt(gb);
+    return cycles;
+}
+#endif
+
+// Runs a predecoded block with the same per-instruction bookkeeping as cpu_step.
+// Bails out early on a taken branch, an interrupt or when the block got overwritten.
+static uint32_t run_block(GB* gb, Block* block, uint64_t* instructions)
+{
+#ifdef JIT
+    const JitCode* code = jit_lookup(gb, block);
+    // Native code doesn't stop for events, so it only runs when none falls inside it
+    if (code && code->max_cycles <= gb->sched.deadline - gb->sched.now)
+        return run_native(gb, code, instructions);
+#endif
+
+    uint32_t elapsed = 0;
+    const DecodedOp* op = block->ops;
+    const DecodedOp* end = op + block->count;
+    do
+    {
+        REG_PC = op->next_pc;
+        uint16_t cycles = op->fn(gb, op);
+        update_ime(gb);
+        sched_advance(&gb->sched, cycles);
+        elapsed += cycles;
+        (*instructions)++;
+        if (gb->cpu.IME && (gb->memory[ADDR_IF] & gb->memory[ADDR_IE]))
         {
-            Condition cond = (opcode == 0xC0) ? NZ : (opcode == 0xC8) ? Z : 
-                            (opcode == 0xD0) ? NC : C;
-            cycles = ret_cc(cpu, cond);
+            handle_interrupt(gb);
+            break;
         }
-        else
+    } while (REG_PC == op->next_pc && block->valid && ++op < end);
+    return elapsed;
+}
+
+// Looks up the block at PC if it fits in what's left of the budget, so a frame
+// ends on exactly the same instruction as with the plain interpreter
+static inline Block* next_block(GB* gb, uint32_t elapsed, uint32_t budget)
+{
+    if (!block_cache_enabled || gb->cpu.halt_bug || dbg.dbg_boot)
+        return NULL;
+    Block* block = block_lookup(gb, REG_PC);
+    if (!block || elapsed + block->cycles > budget) return NULL;
+    return block;
+}
+
+static int idle_reads_safe(GB* gb, const Block* block)
+{
+    if ((block->idle_reads & IDLE_READS_HL) && (REG_HL == ADDR_DIV || REG_HL == ADDR_TIMA)) return 0;
+    if ((block->idle_reads & IDLE_READS_BC) && (REG_BC == ADDR_DIV || REG_BC == ADDR_TIMA)) return 0;
+    if ((block->idle_reads & IDLE_READS_DE) && (REG_DE == ADDR_DIV || REG_DE == ADDR_TIMA)) return 0;
+    return 1;
+}
+
+// If one trip round an idle loop left the CPU exactly as it found it and no event
+// fired meanwhile, every trip until the next event does the same. Those trips are
+// skipped in one go; returns the cycles skipped.
+static uint32_t skip_idle_loop(GB* gb, const Block* block, uint32_t limit)
+{
+    uint64_t cycles = 0;
+    if (gb->idle_watch.block == block && gb->idle_watch.deadline == gb->sched.deadline
+        && gb->idle_watch.time + block->loop_cycles == gb->sched.now
+        && memcmp(&gb->idle_watch.cpu, &gb->cpu, sizeof(CPU)) == 0 && idle_reads_safe(gb, block))
+    {
+        uint64_t span = gb->sched.deadline - gb->sched.now;
+        if (span > limit) span = limit;
+        cycles = span / block->loop_cycles * block->loop_cycles;
+        if (cycles)
         {
-            opcodes[opcode](cpu);
-            cycles = opcode_cycles[opcode];
+            gb->idle_skipped_cycles += cycles;
+            sched_advance(&gb->sched, cycles);
+            if (gb->cpu.IME && (gb->memory[ADDR_IF] & gb->memory[ADDR_IE]))
+                handle_interrupt(gb);
         }
     }
 
-    if (cpu->pending_enable_interrupts) 
-    {
-        cpu->IME = 1;
-        cpu->pending_enable_interrupts = 0;
-    }
-    if (cpu->pending_disable_interrupts) 
+    gb->idle_watch.block = block;
+    gb->idle_watch.cpu = gb->cpu;
+    gb->idle_watch.time = gb->sched.now;
+    gb->idle_watch.deadline = gb->sched.deadline;
+    return cycles;
+}
+
+// Runs (or skips) the cached block at PC; returns 0 if there is none that fits
+static uint32_t run_cached(GB* gb, uint32_t elapsed, uint32_t budget, uint64_t* instructions)
+{
+    Block* block = next_block(gb, elapsed, budget);
+    if (!block || !block->idle_loop || !idle_skip_enabled)
     {
-        cpu->IME = 0;
-        cpu->pending_disable_interrupts = 0;
+        gb->idle_watch.block = NULL;
+        return block ? run_block(gb, block, instructions) : 0;
     }
 
-    if (exec_twice)
+    uint32_t skipped = skip_idle_loop(gb, block, budget - elapsed);
+    return skipped ? skipped : run_block(gb, block, instructions);
+}
+
+#ifndef THREADED_DISPATCH
+
+uint32_t cpu_run(GB* gb, uint32_t budget, uint64_t* instructions)
+{
+    uint32_t elapsed = 0;
+    while (elapsed < budget)
     {
-        REG_PC--;
-        return cpu_step(cpu, ppu);
+        if (gb->cpu.halted || gb->cpu.stopped)
+        {
+            elapsed += skip_idle(gb, budget - elapsed);
+            continue;
+        }
+        uint32_t block_cycles = run_cached(gb, elapsed, budget, instructions);
+        if (block_cycles)
+        {
+            elapsed += block_cycles;
+            continue;
+        }
+        elapsed += cpu_step(gb);
+        (*instructions)++;
     }
+    return elapsed;
+}
 
-    timer_tick(cycles);
+#else
 
-    for (int i = 0; i < cycles && dma.active; i++)
-        dma_step();
+#if !defined(__GNUC__)
+#error "THREADED_DISPATCH needs the labels-as-values extension (GCC/Clang)"
+#endif
 
-    ppu_step(ppu, cycles);
-    if (dbg.dbg_boot)
+// Threaded interpreter: every opcode gets its own label that ends with its own
+// indirect jump to the next opcode, instead of all of them sharing one switch.
+// Anything unusual (HALT/STOP, the HALT bug, boot debugging) goes through cpu_step,
+// and with the block cache on it only picks up code the cache won't take.
+#define LBL(n) &&op_##n,
+#define LBL_ROW(h) LBL(h##0) LBL(h##1) LBL(h##2) LBL(h##3) LBL(h##4) LBL(h##5) LBL(h##6) LBL(h##7) \
+                   LBL(h##8) LBL(h##9) LBL(h##A) LBL(h##B) LBL(h##C) LBL(h##D) LBL(h##E) LBL(h##F)
+
+#define DISPATCH() \
+    do { \
+        if (elapsed >= budget || block_cache_enabled || gb->cpu.halted || gb->cpu.stopped || gb->cpu.halt_bug || dbg.dbg_boot) \
+            goto slow; \
+        goto *dispatch[read_byte(gb, REG_PC++)]; \
+    } while (0)
+
+#define OP(n) \
+    op_##n: \
+        cycles = opcodes[0x##n](gb); \
+        update_ime(gb); \
+        sched_advance(&gb->sched, cycles); \
+        if (gb->cpu.IME && (gb->memory[ADDR_IF] & gb->memory[ADDR_IE])) \
+            handle_interrupt(gb); \
+        elapsed += cycles; \
+        (*instructions)++; \
+        DISPATCH();
+#define OP_ROW(h) OP(h##0) OP(h##1) OP(h##2) OP(h##3) OP(h##4) OP(h##5) OP(h##6) OP(h##7) \
+                  OP(h##8) OP(h##9) OP(h##A) OP(h##B) OP(h##C) OP(h##D) OP(h##E) OP(h##F)
+
+uint32_t cpu_run(GB* gb, uint32_t budget, uint64_t* instructions)
+{
+    static void* const dispatch[256] = {
+        LBL_ROW(0) LBL_ROW(1) LBL_ROW(2) LBL_ROW(3) LBL_ROW(4) LBL_ROW(5) LBL_ROW(6) LBL_ROW(7)
+        LBL_ROW(8) LBL_ROW(9) LBL_ROW(A) LBL_ROW(B) LBL_ROW(C) LBL_ROW(D) LBL_ROW(E) LBL_ROW(F)
+    };
+    uint32_t elapsed = 0;
+    uint16_t cycles;
+
+slow:
+    while (elapsed < budget)
     {
-        if (REG_PC >= 0x0090 && REG_PC <= 0x00A0) 
+        if (gb->cpu.halted || gb->cpu.stopped)
         {
-            DBG_PRINT("Boot ROM LCD sequence: PC=%04X LCDC=%02X LY=%02X\n", 
-                   REG_PC, memory[0xFF40], memory[0xFF44]);
+            elapsed += skip_idle(gb, budget - elapsed);
+            continue;
         }
+        uint32_t block_cycles = run_cached(gb, elapsed, budget, instructions);
+        if (block_cycles)
+        {
+            elapsed += block_cycles;
+            continue;
+        }
+        if (!gb->cpu.halt_bug && !dbg.dbg_boot)
+            goto *dispatch[read_byte(gb, REG_PC++)];
+        elapsed += cpu_step(gb);
+        (*instructions)++;
     }
-    if (cpu->IME && (memory[ADDR_IF] & memory[ADDR_IE]))
-        handle_interrupt(cpu);
-    return cycles;
+    return elapsed;
+
+    OP_ROW(0) OP_ROW(1) OP_ROW(2) OP_ROW(3) OP_ROW(4) OP_ROW(5) OP_ROW(6) OP_ROW(7)
+    OP_ROW(8) OP_ROW(9) OP_ROW(A) OP_ROW(B) OP_ROW(C) OP_ROW(D) OP_ROW(E) OP_ROW(F)
 }
 
+#undef OP_ROW
+#undef OP
+#undef DISPATCH
+#undef LBL_ROW
+#undef LBL
+
+#endif
@@ -3,7 +3,6 @@
 
 #include <stdint.h>
 #include "../memory/memory.h"
-#include "../io/ppu.h"
 
 // Flags
 #define FLAG_Z 0x80 // 0b10000000
@@ -33,20 +32,20 @@ typedef union {
 } RegHL;
 
 // Registers
-#define REG_A cpu->af.A
-#define REG_B cpu->bc.B
-#define REG_C cpu->bc.C
-#define REG_D cpu->de.D
-#define REG_E cpu->de.E
-#define REG_F cpu->af.F
-#define REG_H cpu->hl.H
-#define REG_L cpu->hl.L
-#define REG_AF cpu->af.AF
-#define REG_BC cpu->bc.BC
-#define REG_DE cpu->de.DE
-#define REG_HL cpu->hl.HL
-#define REG_SP cpu->SP
-#define REG_PC cpu->PC
+#define REG_A gb->cpu.af.A
+#define REG_B gb->cpu.bc.B
+#define REG_C gb->cpu.bc.C
+#define REG_D gb->cpu.de.D
+#define REG_E gb->cpu.de.E
+#define REG_F gb->cpu.af.F
+#define REG_H gb->cpu.hl.H
+#define REG_L gb->cpu.hl.L
+#define REG_AF gb->cpu.af.AF
+#define REG_BC gb->cpu.bc.BC
+#define REG_DE gb->cpu.de.DE
+#define REG_HL gb->cpu.hl.HL
+#define REG_SP gb->cpu.SP
+#define REG_PC gb->cpu.PC
 
 // CPU structure
 typedef struct {
@@ -59,23 +58,34 @@ typedef struct {
     uint8_t halted, stopped, halt_bug;
     uint8_t pending_disable_interrupts, pending_enable_interrupts;
     uint8_t IME;
+#ifdef LAZY_FLAGS
+    uint8_t lazy_op;                    // LazyOp whose flags haven't been written to F yet
+    uint8_t lazy_a, lazy_b, lazy_carry; // its operands
+    uint8_t lazy_res;                   // and 8-bit result
+#endif
 } CPU;
 
-typedef struct {
-    uint16_t div_counter;
-    uint16_t tima_counter;
-    uint32_t cycle_counter;
-    uint8_t overflow;
-    uint8_t delay;
-} Timer;
+// With LAZY_FLAGS the ALU helpers only record what they did, F is worked out
+// when something reads it. FLAGS_SYNC before reading F (or changing part of it),
+// FLAGS_DROP before overwriting all of it.
+#ifdef LAZY_FLAGS
+typedef enum { LAZY_NONE, LAZY_ADD, LAZY_SUB, LAZY_AND, LAZY_OR, LAZY_INC, LAZY_DEC } LazyOp;
+void flags_materialize(GB* gb);
+#define FLAGS_SYNC(gb) do { if ((gb)->cpu.lazy_op) flags_materialize(gb); } while (0)
+#define FLAGS_DROP(gb) ((gb)->cpu.lazy_op = LAZY_NONE)
+#else
+#define FLAGS_SYNC(gb) ((void)0)
+#define FLAGS_DROP(gb) ((void)0)
+#endif
 
-extern Timer cpu_timer;
 typedef enum { NZ, Z, NC, C } Condition;
 typedef enum { VBLANK_INT, STAT_INT, TIMER_INT, SERIAL_INT, JOYPAD_INT } Interrupt;
 
-void print_cpu_state(CPU* cpu);
-void cpu_init(CPU* cpu);
-uint16_t cpu_step(CPU* cpu, PPU* ppu);
-static inline void request_interrupt(Interrupt interrupt) { memory[ADDR_IF] |= (1 << interrupt); }
+extern uint8_t idle_skip_enabled;
+
+void print_cpu_state(const CPU* cpu);
+void cpu_init(GB* gb);
+uint16_t cpu_step(GB* gb);
+uint32_t cpu_run(GB* gb, uint32_t budget, uint64_t* instructions);
 
 #endif // CPU_H
@@ -1,91 +1,109 @@
 #include "instructions.h"
 #include "../memory/memory.h"
 #include "cpu.h"
+#include "../core/gb.h"
 #include <stdint.h>
+#ifdef ALU_TABLES
+#include "alu_tables.h"  // generated by tools/gen_alu_tables.c
 
-void ld_rx_ry(CPU* cpu, uint8_t* dest, uint8_t* src) { *dest = *src; } // ry into rx
-void ld_rx_hl(CPU* cpu, uint8_t* dest) { *dest = read_byte(REG_HL); }
-void ld_hl_ry(CPU* cpu, uint8_t* src) { write_byte(REG_HL, *src); }
-void ld_r_n(CPU* cpu, uint8_t* dest) { *dest = read_byte(REG_PC++); } // next byte into register
+typedef enum { SH_RLC, SH_RRC, SH_RL, SH_RR, SH_SLA, SH_SRA, SH_SRL, SH_SWAP } ShiftOp;
 
-void ld_r_nn(CPU* cpu, uint8_t* dest) 
+static inline uint8_t shift_lookup(GB* gb, ShiftOp op, uint8_t value, uint8_t carry)
 {
-    uint16_t addr = read_byte(REG_PC++) | (read_byte(REG_PC++) << 8);
-    *dest = read_byte(addr);
+    uint16_t entry = alu_shift[op][carry][value];
+    REG_F = entry >> 8;
+    return entry & 0xFF;
 }
+#endif
 
-void ld_nn_r(CPU* cpu, uint8_t* src)
+void ld_rx_ry(GB* gb, uint8_t* dest, uint8_t* src) { *dest = *src; } // ry into rx
+void ld_rx_hl(GB* gb, uint8_t* dest) { *dest = read_byte(gb, REG_HL); }
+void ld_hl_ry(GB* gb, uint8_t* src) { write_byte(gb, REG_HL, *src); }
+void ld_r_n(GB* gb, uint8_t* dest) { *dest = read_byte(gb, REG_PC++); } // next byte into register
+
+void ld_r_nn(GB* gb, uint8_t* dest) 
+{
+    uint8_t low = read_byte(gb, REG_PC++);
+    uint8_t high = read_byte(gb, REG_PC++);
+    uint16_t addr = (high << 8) | low;
+    *dest = read_byte(gb, addr);
+}
+
+void ld_nn_r(GB* gb, uint8_t* src)
 {
-    uint16_t addr = read_byte(REG_PC++) | (read_byte(REG_PC++) << 8);
-    write_byte(addr, *src); // register to 16 bit intermediate mem location   
+    uint8_t low = read_byte(gb, REG_PC++);
+    uint8_t high = read_byte(gb, REG_PC++);
+    uint16_t addr = (high << 8) | low;
+    write_byte(gb, addr, *src); // register to 16 bit intermediate mem location   
 }
 
-void ld_r_rr(CPU* cpu, uint8_t* dest, uint16_t addr) { *dest = read_byte(addr); } // address in register pair into dest reg
-void ld_rr_r(CPU* cpu, uint8_t* src, uint16_t addr){ write_byte(addr, *src); } // register into mem location
+void ld_r_rr(GB* gb, uint8_t* dest, uint16_t addr) { *dest = read_byte(gb, addr); } // address in register pair into dest reg
+void ld_rr_r(GB* gb, uint8_t* src, uint16_t addr){ write_byte(gb, addr, *src); } // register into mem location
 
-void ld_a_c(CPU* cpu)
+void ld_a_c(GB* gb)
 {
     uint16_t addr = 0xFF00 + REG_C;
-    REG_A = read_byte(addr); // Value at address 0xFF00 + reg C into reg A
+    REG_A = read_byte(gb, addr); // Value at address 0xFF00 + reg C into reg A
 }
 
-void ld_c_a(CPU* cpu)
+void ld_c_a(GB* gb)
 {
     uint16_t addr = 0xFF00 + REG_C;
-    write_byte(addr, REG_A); // Value in reg A to address 0xFF00 + reg C
+    write_byte(gb, addr, REG_A); // Value in reg A to address 0xFF00 + reg C
 }
 
-void ldd_a_hl(CPU* cpu)
+void ldd_a_hl(GB* gb)
 {
-    REG_A = read_byte(REG_HL);
+    REG_A = read_byte(gb, REG_HL);
     REG_HL--;
 }
 
-void ldd_hl_a(CPU* cpu)
+void ldd_hl_a(GB* gb)
 {
-    write_byte(REG_HL, REG_A);
+    write_byte(gb, REG_HL, REG_A);
     REG_HL--;
 }
 
-void ldi_a_hl(CPU* cpu)
+void ldi_a_hl(GB* gb)
 {
-    REG_A = read_byte(REG_HL);
+    REG_A = read_byte(gb, REG_HL);
     REG_HL++;
 }
 
-void ldi_hl_a(CPU* cpu)
+void ldi_hl_a(GB* gb)
 {
-    write_byte(REG_HL, REG_A);
+    write_byte(gb, REG_HL, REG_A);
     REG_HL++;
 }
 
-void ldh_n_a(CPU* cpu)
+void ldh_n_a(GB* gb)
 {
-    uint16_t addr = 0xFF00 + read_byte(REG_PC++);
-    write_byte(addr, REG_A);
+    uint16_t addr = 0xFF00 + read_byte(gb, REG_PC++);
+    write_byte(gb, addr, REG_A);
 }
 
-void ldh_a_n(CPU* cpu)
+void ldh_a_n(GB* gb)
 {
-    uint16_t addr = 0xFF00 + read_byte(REG_PC++);
-    REG_A = read_byte(addr);
+    uint16_t addr = 0xFF00 + read_byte(gb, REG_PC++);
+    REG_A = read_byte(gb, addr);
 }
 
-void ld_n_nn(CPU* cpu, uint16_t* dest) 
+void ld_n_nn(GB* gb, uint16_t* dest) 
 {
-    uint8_t low = read_byte(REG_PC++);
-    uint8_t high = read_byte(REG_PC++);
+    uint8_t low = read_byte(gb, REG_PC++);
+    uint8_t high = read_byte(gb, REG_PC++);
     uint16_t addr = (high << 8) | low;
-    *dest = read_byte(addr) | (read_byte(addr + 1) << 8); // address of next two bytes into register
+    *dest = read_byte(gb, addr) | (read_byte(gb, addr + 1) << 8); // address of next two bytes into register
 }
 
-void ld_sp_hl(CPU* cpu) { REG_SP = REG_HL; }
+void ld_sp_hl(GB* gb) { REG_SP = REG_HL; }
 
-void ldhl_sp_n(CPU* cpu)
+void ldhl_sp_n(GB* gb)
 {
-    int8_t n = (int8_t)read_byte(REG_PC++);
+    int8_t n = (int8_t)read_byte(gb, REG_PC++);
     uint16_t result = REG_SP + n;
 
+    FLAGS_DROP(gb);
     REG_F &= ~(FLAG_Z | FLAG_N | FLAG_H | FLAG_C);
 
     if (((REG_SP & 0xF) + (n & 0xF)) > 0xF) REG_F |= FLAG_H;
@@ -94,32 +112,105 @@ void ldhl_sp_n(CPU* cpu)
     REG_HL = result;
 }
 
-void ld_nn_sp(CPU* cpu)
+void ld_nn_sp(GB* gb)
 {
-    uint8_t low = read_byte(REG_PC++);
-    uint8_t high = read_byte(REG_PC++);
+    uint8_t low = read_byte(gb, REG_PC++);
+    uint8_t high = read_byte(gb, REG_PC++);
     uint16_t addr = (high << 8) | low;
-    write_byte(addr, REG_SP & 0xFF);
-    write_byte(addr + 1, REG_SP >> 8);
+    write_byte(gb, addr, REG_SP & 0xFF);
+    write_byte(gb, addr + 1, REG_SP >> 8);
 }
 
-void push_nn(CPU* cpu, uint16_t value) 
+void push_nn(GB* gb, uint16_t value) 
 {
-    write_byte(--REG_SP, (value >> 8));
-    write_byte(--REG_SP, (value & 0xFF));
+    write_byte(gb, --REG_SP, (value >> 8));
+    write_byte(gb, --REG_SP, (value & 0xFF));
 }
 
-uint16_t pop_nn(CPU* cpu) 
+uint16_t pop_nn(GB* gb) 
 {
-    uint16_t low  = read_byte(REG_SP++);
-    uint16_t high = read_byte(REG_SP++);
+    uint16_t low  = read_byte(gb, REG_SP++);
+    uint16_t high = read_byte(gb, REG_SP++);
     return (high << 8) | low;
 }
 
-void add_a_n(CPU* cpu, uint8_t value)
+#ifdef LAZY_FLAGS
+static inline void flags_record(GB* gb, LazyOp op, uint8_t a, uint8_t b, uint8_t carry, uint8_t result)
+{
+    gb->cpu.lazy_op = op;
+    gb->cpu.lazy_a = a;
+    gb->cpu.lazy_b = b;
+    gb->cpu.lazy_carry = carry;
+    gb->cpu.lazy_res = result;
+}
+
+// Produces exactly what the eager helpers below would have left in F
+void flags_materialize(GB* gb)
+{
+    uint8_t a = gb->cpu.lazy_a, b = gb->cpu.lazy_b, carry = gb->cpu.lazy_carry;
+    uint8_t flags = gb->cpu.lazy_res == 0 ? FLAG_Z : 0;
+    switch (gb->cpu.lazy_op)
+    {
+        case LAZY_NONE:
+            return;
+        case LAZY_ADD:
+#ifdef ALU_TABLES
+            flags = alu_add_flags[carry][a][b];
+            break;
+#endif
+            if (((a & 0xF) + (b & 0xF) + carry) > 0xF) flags |= FLAG_H;
+            if (a + b + carry > 0xFF) flags |= FLAG_C;
+            break;
+        case LAZY_SUB:
+#ifdef ALU_TABLES
+            flags = alu_sub_flags[carry][a][b];
+            break;
+#endif
+            flags |= FLAG_N;
+            if ((a & 0xF) < ((b & 0xF) + carry)) flags |= FLAG_H;
+            if (a < b + carry) flags |= FLAG_C;
+            break;
+        case LAZY_AND:
+            flags |= FLAG_H;
+            break;
+        case LAZY_OR:
+            break;
+        case LAZY_INC:
+#ifdef ALU_TABLES
+            flags = (REG_F & FLAG_C) | alu_inc_flags[gb->cpu.lazy_res];
+            break;
+#endif
+            flags |= REG_F & FLAG_C;
+            if ((gb->cpu.lazy_res & 0xF) == 0x0) flags |= FLAG_H;
+            break;
+        case LAZY_DEC:
+#ifdef ALU_TABLES
+            flags = (REG_F & FLAG_C) | alu_dec_flags[gb->cpu.lazy_res];
+            break;
+#endif
+            flags |= (REG_F & FLAG_C) | FLAG_N;
+            if ((gb->cpu.lazy_res & 0xF) == 0xF) flags |= FLAG_H;
+            break;
+    }
+    REG_F = flags;
+    gb->cpu.lazy_op = LAZY_NONE;
+}
+#endif
+
+void add_a_n(GB* gb, uint8_t value)
 {
     uint8_t a = REG_A;
     uint16_t result = a + value;
+#ifdef LAZY_FLAGS
+    flags_record(gb, LAZY_ADD, a, value, 0, result);
+    REG_A = result & 0xFF;
+    return;
+#endif
+#ifdef ALU_TABLES
+    REG_F = alu_add_flags[0][a][value];
+    REG_A = result & 0xFF;
+    return;
+#endif
     REG_F = 0; 
     if ((result & 0xFF) == 0) REG_F |= FLAG_Z; // Z
     // N flag (Subtract) -> always 0 for ADD, skip
@@ -128,11 +219,22 @@ void add_a_n(CPU* cpu, uint8_t value)
     REG_A = result & 0xFF;
 }
 
-void adc_a_n(CPU* cpu, uint8_t value)
+void adc_a_n(GB* gb, uint8_t value)
 {
+    FLAGS_SYNC(gb);
     uint8_t a = REG_A;
     uint8_t carry = (REG_F & FLAG_C) ? 1 : 0;
     uint16_t result = a + value + carry;
+#ifdef LAZY_FLAGS
+    flags_record(gb, LAZY_ADD, a, value, carry, result);
+    REG_A = result & 0xFF;
+    return;
+#endif
+#ifdef ALU_TABLES
+    REG_F = alu_add_flags[carry][a][value];
+    REG_A = result & 0xFF;
+    return;
+#endif
     REG_F = 0;
     if ((result & 0xFF) == 0) REG_F |= FLAG_Z; // Z
     // N flag (Subtract) -> always 0 for ADD, skip
@@ -141,10 +243,20 @@ void adc_a_n(CPU* cpu, uint8_t value)
     REG_A = result & 0xFF;  
 }
 
-void sub_a_n(CPU* cpu, uint8_t value)
+void sub_a_n(GB* gb, uint8_t value)
 {
     uint8_t a = REG_A;
     uint16_t result = a - value;
+#ifdef LAZY_FLAGS
+    flags_record(gb, LAZY_SUB, a, value, 0, result);
+    REG_A = result & 0xFF;
+    return;
+#endif
+#ifdef ALU_TABLES
+    REG_F = alu_sub_flags[0][a][value];
+    REG_A = result & 0xFF;
+    return;
+#endif
     REG_F = 0;
     REG_F |= FLAG_N; // N flag — Always set for subtraction
     if ((result & 0xFF) == 0) REG_F |= FLAG_Z;
@@ -153,11 +265,22 @@ void sub_a_n(CPU* cpu, uint8_t value)
     REG_A = result & 0xFF;
 }
 
-void sbc_a_n(CPU* cpu, uint8_t value)
+void sbc_a_n(GB* gb, uint8_t value)
 {
+    FLAGS_SYNC(gb);
     uint8_t a = REG_A;
     uint8_t carry = (REG_F & FLAG_C) ? 1 : 0;
     uint16_t result = a - value - carry;
+#ifdef LAZY_FLAGS
+    flags_record(gb, LAZY_SUB, a, value, carry, result);
+    REG_A = result & 0xFF;
+    return;
+#endif
+#ifdef ALU_TABLES
+    REG_F = alu_sub_flags[carry][a][value];
+    REG_A = result & 0xFF;
+    return;
+#endif
     REG_F = 0;
     REG_F |= FLAG_N; // N flag — Always set for subtraction
     if ((result & 0xFF) == 0) REG_F |= FLAG_Z;
@@ -166,31 +289,51 @@ void sbc_a_n(CPU* cpu, uint8_t value)
     REG_A = result & 0xFF;
 }
 
-void and_a_n(CPU* cpu, uint8_t value)
+void and_a_n(GB* gb, uint8_t value)
 {
     REG_A &= value;
+#ifdef LAZY_FLAGS
+    flags_record(gb, LAZY_AND, 0, 0, 0, REG_A);
+    return;
+#endif
     REG_F = 0;
     REG_F |= FLAG_H; // H flag set
     if (REG_A == 0) REG_F |= FLAG_Z;
 }
 
-void or_a_n(CPU* cpu, uint8_t value)
+void or_a_n(GB* gb, uint8_t value)
 {
     REG_A |= value;
+#ifdef LAZY_FLAGS
+    flags_record(gb, LAZY_OR, 0, 0, 0, REG_A);
+    return;
+#endif
     REG_F = 0;
     if (REG_A == 0) REG_F |= FLAG_Z;
 }
 
-void xor_a_n(CPU* cpu, uint8_t value)
+void xor_a_n(GB* gb, uint8_t value)
 {
     REG_A ^= value;
+#ifdef LAZY_FLAGS
+    flags_record(gb, LAZY_OR, 0, 0, 0, REG_A);
+    return;
+#endif
     REG_F = 0;
     if (REG_A == 0) REG_F |= FLAG_Z;
 }
 
-void cp_a_n(CPU* cpu, uint8_t value)
+void cp_a_n(GB* gb, uint8_t value)
 {
     uint8_t result = REG_A - value;
+#ifdef LAZY_FLAGS
+    flags_record(gb, LAZY_SUB, REG_A, value, 0, result);
+    return;
+#endif
+#ifdef ALU_TABLES
+    REG_F = alu_sub_flags[0][REG_A][value];
+    return;
+#endif
     REG_F = 0;
     REG_F |= FLAG_N;
     if (result == 0) REG_F |= FLAG_Z;
@@ -198,10 +341,21 @@ void cp_a_n(CPU* cpu, uint8_t value)
     if (REG_A < value) REG_F |= FLAG_C; // No borrow
 }
 
-void inc_n(CPU* cpu, uint8_t* reg) 
+void inc_n(GB* gb, uint8_t* reg) 
 { 
     uint8_t value = *reg;
     uint8_t result = value + 1;
+#ifdef LAZY_FLAGS
+    FLAGS_SYNC(gb);  // C carries over from the previous instruction
+    flags_record(gb, LAZY_INC, 0, 0, 0, result);
+    *reg = result;
+    return;
+#endif
+#ifdef ALU_TABLES
+    REG_F = (REG_F & FLAG_C) | alu_inc_flags[result];
+    *reg = result;
+    return;
+#endif
     // Preserve carry flag
     uint8_t carry = REG_F & FLAG_C;
     // Reset N and H, will recompute H if needed
@@ -212,10 +366,21 @@ void inc_n(CPU* cpu, uint8_t* reg)
     *reg = result;
 }
 
-void dec_n(CPU* cpu, uint8_t* reg) 
+void dec_n(GB* gb, uint8_t* reg) 
 { 
     uint8_t value = *reg;
     uint8_t result = value - 1;
+#ifdef LAZY_FLAGS
+    FLAGS_SYNC(gb);
+    flags_record(gb, LAZY_DEC, 0, 0, 0, result);
+    *reg = result;
+    return;
+#endif
+#ifdef ALU_TABLES
+    REG_F = (REG_F & FLAG_C) | alu_dec_flags[result];
+    *reg = result;
+    return;
+#endif
     // Preserve carry flag
     uint8_t flags = (REG_F & FLAG_C) | FLAG_N;
     // Set N, compute H for half-borrow
@@ -226,10 +391,11 @@ void dec_n(CPU* cpu, uint8_t* reg)
     *reg = result;
 }
 
-void add_hl_n(CPU* cpu, uint16_t* reg)
+void add_hl_n(GB* gb, uint16_t* reg)
 {
     uint32_t result = REG_HL + *reg;      
 
+    FLAGS_SYNC(gb);
     REG_F &= FLAG_Z;
     REG_F &= ~FLAG_N;
     // H: carry from bit 11
@@ -239,10 +405,11 @@ void add_hl_n(CPU* cpu, uint16_t* reg)
     REG_HL = (uint16_t)result;
 }
 
-void add_sp_n(CPU* cpu)
+void add_sp_n(GB* gb)
 {
-    int8_t n = (int8_t)read_byte(REG_PC++);
+    int8_t n = (int8_t)read_byte(gb, REG_PC++);
     uint16_t sp = REG_SP;
+    FLAGS_DROP(gb);
     REG_F = 0;
     // Flags calculated on lower byte only
     if (((sp & 0xF) + (n & 0xF)) > 0xF) REG_F |= FLAG_H;
@@ -250,27 +417,39 @@ void add_sp_n(CPU* cpu)
     REG_SP = sp + n;  // Signed addition
 }
 
-void inc_nn(CPU* cpu, uint16_t* reg) { ++(*reg); }
-void dec_nn(CPU* cpu, uint16_t* reg) { --(*reg); }
+void inc_nn(GB* gb, uint16_t* reg) { ++(*reg); }
+void dec_nn(GB* gb, uint16_t* reg) { --(*reg); }
 
-void swap_n(CPU* cpu, uint8_t* reg)
+void swap_n(GB* gb, uint8_t* reg)
 {
+#ifdef ALU_TABLES
+    FLAGS_DROP(gb);
+    *reg = shift_lookup(gb, SH_SWAP, *reg, 0);
+    return;
+#endif
     uint8_t value = *reg;
     *reg = (value << 4) | (value >> 4);
+    FLAGS_DROP(gb);
     REG_F = 0;
     if (*reg == 0) REG_F |= FLAG_Z;
 }
 
-void swap_hl(CPU* cpu)
+void swap_hl(GB* gb)
 {
-    uint8_t value = read_byte(REG_HL);
+    uint8_t value = read_byte(gb, REG_HL);
     value = (value << 4) | (value >> 4);
-    write_byte(REG_HL, value);
+    write_byte(gb, REG_HL, value);
+    FLAGS_DROP(gb);
     REG_F = (value == 0) ? FLAG_Z : 0;
 }
 
-void daa_a(CPU* cpu)
+void daa_a(GB* gb)
 {
+    FLAGS_SYNC(gb);
+#ifdef ALU_TABLES
+    REG_AF = alu_daa[(REG_F >> 4) & 7][REG_A];
+    return;
+#endif
     uint8_t a = REG_A;
     uint8_t adjust = 0;
     uint8_t carry = 0;
@@ -299,31 +478,49 @@ void daa_a(CPU* cpu)
     if (carry) REG_F |= FLAG_C;
 }
 
-void cpl_a(CPU* cpu)
+void cpl_a(GB* gb)
 {
     REG_A ^= 0xFF;
+    FLAGS_SYNC(gb);
     REG_F |= FLAG_N | FLAG_H;
 }
 
-void ccf(CPU* cpu)
+void ccf(GB* gb)
 {
+    FLAGS_SYNC(gb);
     REG_F = (REG_F & (FLAG_Z)) | ((REG_F & FLAG_C) ? 0 : FLAG_C);
     REG_F = (REG_F & FLAG_Z) ^ FLAG_C;  // Toggle carry, preserve Z
 }
 
-void scf(CPU* cpu) { REG_F = (REG_F & FLAG_Z) | FLAG_C; }
+void scf(GB* gb)
+{
+    FLAGS_SYNC(gb);
+    REG_F = (REG_F & FLAG_Z) | FLAG_C;
+}
 
-void rrc(CPU* cpu, uint8_t* reg)
+void rrc(GB* gb, uint8_t* reg)
 {
+#ifdef ALU_TABLES
+    FLAGS_DROP(gb);
+    *reg = shift_lookup(gb, SH_RRC, *reg, 0);
+    return;
+#endif
     uint8_t bit0 = *reg & 0x01;
     *reg = (*reg >> 1) | (bit0 << 7);
+    FLAGS_DROP(gb);
     REG_F = 0;
     if (*reg == 0) REG_F |= FLAG_Z;
     if (bit0) REG_F |= FLAG_C;
 }
 
-void rrn(CPU* cpu, uint8_t* reg)
+void rrn(GB* gb, uint8_t* reg)
 {
+#ifdef ALU_TABLES
+    FLAGS_SYNC(gb);
+    *reg = shift_lookup(gb, SH_RR, *reg, (REG_F & FLAG_C) ? 1 : 0);
+    return;
+#endif
+    FLAGS_SYNC(gb);
     uint8_t oldCarry = (REG_F & FLAG_C) ? 1 : 0;
     uint8_t bit0 = *reg & 0x01;
 
@@ -334,17 +531,29 @@ void rrn(CPU* cpu, uint8_t* reg)
     if (bit0) REG_F |= FLAG_C;
 }
 
-void rlc(CPU* cpu, uint8_t* reg)
+void rlc(GB* gb, uint8_t* reg)
 {
+#ifdef ALU_TABLES
+    FLAGS_DROP(gb);
+    *reg = shift_lookup(gb, SH_RLC, *reg, 0);
+    return;
+#endif
     uint8_t bit7 = (*reg & 0x80) >> 7;
     *reg = (*reg << 1) | bit7;
+    FLAGS_DROP(gb);
     REG_F = 0;
     if (*reg == 0) REG_F |= FLAG_Z;
     if (bit7) REG_F |= FLAG_C;
 }
 
-void rl(CPU* cpu, uint8_t* reg)
+void rl(GB* gb, uint8_t* reg)
 {
+#ifdef ALU_TABLES
+    FLAGS_SYNC(gb);
+    *reg = shift_lookup(gb, SH_RL, *reg, (REG_F & FLAG_C) ? 1 : 0);
+    return;
+#endif
+    FLAGS_SYNC(gb);
     uint8_t oldCarry = (REG_F & FLAG_C) ? 1 : 0;
     uint8_t bit7 = (*reg & 0x80) >> 7;
     *reg = (*reg << 1) | oldCarry;
@@ -353,36 +562,55 @@ void rl(CPU* cpu, uint8_t* reg)
     if (bit7) REG_F |= FLAG_C;
 }
 
-void sla(CPU* cpu, uint8_t* reg)
+void sla(GB* gb, uint8_t* reg)
 {
+#ifdef ALU_TABLES
+    FLAGS_DROP(gb);
+    *reg = shift_lookup(gb, SH_SLA, *reg, 0);
+    return;
+#endif
     uint8_t old = *reg;
     *reg <<= 1;
+    FLAGS_DROP(gb);
     REG_F = 0;
     if (*reg == 0) REG_F |= FLAG_Z;
     if (old & 0x80) REG_F |= FLAG_C;
 }
 
-void sra(CPU* cpu, uint8_t* reg)
+void sra(GB* gb, uint8_t* reg)
 {
+#ifdef ALU_TABLES
+    FLAGS_DROP(gb);
+    *reg = shift_lookup(gb, SH_SRA, *reg, 0);
+    return;
+#endif
     uint8_t old = *reg;
     uint8_t msb = old & 0x80;
     *reg = (old >> 1) | msb;
+    FLAGS_DROP(gb);
     REG_F = 0;
     if (*reg == 0) REG_F |= FLAG_Z;
     if (old & 0x01) REG_F |= FLAG_C;
 }
 
-void srl(CPU* cpu, uint8_t* reg)
+void srl(GB* gb, uint8_t* reg)
 {
+#ifdef ALU_TABLES
+    FLAGS_DROP(gb);
+    *reg = shift_lookup(gb, SH_SRL, *reg, 0);
+    return;
+#endif
     uint8_t old = *reg;
     *reg >>= 1;
+    FLAGS_DROP(gb);
     REG_F = 0;
     if (*reg == 0) REG_F |= FLAG_Z;
     if (old & 0x01) REG_F |= FLAG_C;
 }
 
-void bit(uint8_t bit, uint8_t* reg, CPU* cpu)
+void bit(uint8_t bit, uint8_t* reg, GB* gb)
 {
+    FLAGS_SYNC(gb);
     uint8_t carry = REG_F & FLAG_C;  // Preserve carry
     REG_F = FLAG_H | carry;          // H set, N cleared
     if (!(*reg & (1 << bit))) REG_F |= FLAG_Z;
@@ -391,20 +619,21 @@ void bit(uint8_t bit, uint8_t* reg, CPU* cpu)
 void res(uint8_t bit, uint8_t* reg) { *reg &= ~(1 << bit); }
 void set(uint8_t bit, uint8_t* reg) { *reg |= (1 << bit); }
 
-void jp_nn(CPU* cpu)
+void jp_nn(GB* gb)
 {
-    uint8_t low  = read_byte(REG_PC++);
-    uint8_t high = read_byte(REG_PC++);
+    uint8_t low  = read_byte(gb, REG_PC++);
+    uint8_t high = read_byte(gb, REG_PC++);
     REG_PC = (high << 8) | low;
 }
 
-uint8_t jp_cc_nn(CPU* cpu, Condition condition)
+uint8_t jp_cc_nn(GB* gb, Condition condition)
 {
-    uint8_t low = read_byte(REG_PC++);
-    uint8_t high = read_byte(REG_PC++);
+    uint8_t low = read_byte(gb, REG_PC++);
+    uint8_t high = read_byte(gb, REG_PC++);
     uint16_t addr = (high << 8) | low;
 
     uint8_t taken = 0;
+    FLAGS_SYNC(gb);
     switch (condition)
     {
         case NZ:
@@ -439,18 +668,19 @@ uint8_t jp_cc_nn(CPU* cpu, Condition condition)
     return taken ? 16 : 12;
 }
 
-void jp_hl(CPU* cpu) { REG_PC = REG_HL; }
+void jp_hl(GB* gb) { REG_PC = REG_HL; }
 
-void jr_n(CPU* cpu)
+void jr_n(GB* gb)
 {
-    int8_t offset = read_byte(REG_PC++);
+    int8_t offset = read_byte(gb, REG_PC++);
     REG_PC += offset;
 }
 
-uint8_t jr_cc_n(CPU* cpu, Condition condition)
+uint8_t jr_cc_n(GB* gb, Condition condition)
 {
-    int8_t offset = read_byte(REG_PC++);
+    int8_t offset = read_byte(gb, REG_PC++);
     uint8_t taken = 0;
+    FLAGS_SYNC(gb);
     switch (condition)
     {
         case NZ:
@@ -485,21 +715,22 @@ uint8_t jr_cc_n(CPU* cpu, Condition condition)
     return taken ? 12 : 8;
 }
 
-void call_nn(CPU* cpu)
+void call_nn(GB* gb)
 {
-    uint8_t low = read_byte(REG_PC++);
-    uint8_t high = read_byte(REG_PC++);
+    uint8_t low = read_byte(gb, REG_PC++);
+    uint8_t high = read_byte(gb, REG_PC++);
     uint16_t addr = (high << 8) | low;
-    push_nn(cpu, REG_PC);
+    push_nn(gb, REG_PC);
     REG_PC = addr;
 }
 
-uint8_t call_cc_nn(CPU* cpu, Condition condition)
+uint8_t call_cc_nn(GB* gb, Condition condition)
 {
-    uint8_t low = read_byte(REG_PC++);
-    uint8_t high = read_byte(REG_PC++);
+    uint8_t low = read_byte(gb, REG_PC++);
+    uint8_t high = read_byte(gb, REG_PC++);
     uint16_t addr = (high << 8) | low;
 
+    FLAGS_SYNC(gb);
     switch (condition)
     {
         case NZ:
@@ -517,49 +748,50 @@ uint8_t call_cc_nn(CPU* cpu, Condition condition)
     }
     return 12;
 call:
-    push_nn(cpu, REG_PC);
+    push_nn(gb, REG_PC);
     REG_PC = addr;
     return 24;
 }
 
-void rst_n(CPU* cpu, uint8_t value)
+void rst_n(GB* gb, uint8_t value)
 {
-    push_nn(cpu, REG_PC);
+    push_nn(gb, REG_PC);
     REG_PC = value;
 }
 
-void ret(CPU* cpu) { REG_PC = pop_nn(cpu); }
+void ret(GB* gb) { REG_PC = pop_nn(gb); }
 
-uint8_t ret_cc(CPU* cpu, Condition condition)
+uint8_t ret_cc(GB* gb, Condition condition)
 {
     uint8_t taken = 0;
+    FLAGS_SYNC(gb);
     switch (condition)
     {
         case NZ:
             if (!(REG_F & FLAG_Z)) 
             {
-                REG_PC = pop_nn(cpu);
+                REG_PC = pop_nn(gb);
                 taken = 1;
             }
             break;
         case Z:
             if (REG_F & FLAG_Z) 
             {
-                REG_PC = pop_nn(cpu);
+                REG_PC = pop_nn(gb);
                 taken = 1;
             }
             break;
         case NC:
             if (!(REG_F & FLAG_C)) 
             {
-                REG_PC = pop_nn(cpu);
+                REG_PC = pop_nn(gb);
                 taken = 1;
             }
             break;
         case C:
             if (REG_F & FLAG_C) 
             {
-                REG_PC = pop_nn(cpu);
+                REG_PC = pop_nn(gb);
                 taken = 1;
             }
             break;
@@ -567,9 +799,9 @@ uint8_t ret_cc(CPU* cpu, Condition condition)
     return taken ? 20 : 8;
 }
 
-void reti(CPU* cpu)
+void reti(GB* gb)
 {
-    REG_PC = pop_nn(cpu);
-    cpu->IME = 1;
+    REG_PC = pop_nn(gb);
+    gb->cpu.IME = 1;
 }
 
@@ -4,68 +4,68 @@
 #include "cpu.h"
 
 // Instruction pattern prototypes
-void ld_rx_ry(CPU* cpu, uint8_t* dest, uint8_t* src);
-void ld_rx_hl(CPU* cpu, uint8_t* dest);
-void ld_hl_ry(CPU* cpu, uint8_t* src);
-void ld_r_n(CPU* cpu, uint8_t* dest);
-void ld_r_nn(CPU* cpu, uint8_t* dest);
-void ld_nn_r(CPU* cpu, uint8_t* src);
-void ld_r_rr(CPU* cpu, uint8_t* dest, uint16_t addr);
-void ld_rr_r(CPU* cpu, uint8_t* src, uint16_t addr);
-void ld_a_c(CPU* cpu);
-void ld_c_a(CPU* cpu);
-void ldd_a_hl(CPU* cpu);
-void ldd_hl_a(CPU* cpu);
-void ldi_a_hl(CPU* cpu);
-void ldi_hl_a(CPU* cpu);
-void ldh_n_a(CPU* cpu);
-void ldh_a_n(CPU* cpu);
-void ld_n_nn(CPU* cpu, uint16_t* dest);
-void ld_sp_hl(CPU* cpu);
-void ldhl_sp_n(CPU* cpu);
-void ld_nn_sp(CPU* cpu);
-void push_nn(CPU* cpu, uint16_t value);
-uint16_t pop_nn(CPU* cpu);
-void add_a_n(CPU* cpu, uint8_t value);
-void adc_a_n(CPU* cpu, uint8_t value);
-void sub_a_n(CPU* cpu, uint8_t value);
-void sbc_a_n(CPU* cpu, uint8_t value);
-void and_a_n(CPU* cpu, uint8_t value);
-void or_a_n(CPU* cpu, uint8_t value);
-void xor_a_n(CPU* cpu, uint8_t value);
-void cp_a_n(CPU* cpu, uint8_t value);
-void inc_n(CPU* cpu, uint8_t* reg);
-void dec_n(CPU* cpu, uint8_t* reg);
-void add_hl_n(CPU* cpu, uint16_t* reg);
-void add_sp_n(CPU* cpu);
-void inc_nn(CPU* cpu, uint16_t* reg);
-void dec_nn(CPU* cpu, uint16_t* reg);
-void swap_n(CPU* cpu, uint8_t* reg);
-void swap_hl(CPU* cpu);
-void daa_a(CPU* cpu);
-void cpl_a(CPU* cpu);
-void ccf(CPU* cpu);
-void scf(CPU* cpu);
-void rl(CPU* cpu, uint8_t* reg);
-void rrc(CPU* cpu, uint8_t* reg);
-void rrn(CPU* cpu, uint8_t* reg);
-void rlc(CPU* cpu, uint8_t* reg);
-void sla(CPU* cpu, uint8_t* reg);
-void sra(CPU* cpu, uint8_t* reg);
-void srl(CPU* cpu, uint8_t* reg);
-void bit(uint8_t bit, uint8_t* reg, CPU* cpu);
+void ld_rx_ry(GB* gb, uint8_t* dest, uint8_t* src);
+void ld_rx_hl(GB* gb, uint8_t* dest);
+void ld_hl_ry(GB* gb, uint8_t* src);
+void ld_r_n(GB* gb, uint8_t* dest);
+void ld_r_nn(GB* gb, uint8_t* dest);
+void ld_nn_r(GB* gb, uint8_t* src);
+void ld_r_rr(GB* gb, uint8_t* dest, uint16_t addr);
+void ld_rr_r(GB* gb, uint8_t* src, uint16_t addr);
+void ld_a_c(GB* gb);
+void ld_c_a(GB* gb);
+void ldd_a_hl(GB* gb);
+void ldd_hl_a(GB* gb);
+void ldi_a_hl(GB* gb);
+void ldi_hl_a(GB* gb);
+void ldh_n_a(GB* gb);
+void ldh_a_n(GB* gb);
+void ld_n_nn(GB* gb, uint16_t* dest);
+void ld_sp_hl(GB* gb);
+void ldhl_sp_n(GB* gb);
+void ld_nn_sp(GB* gb);
+void push_nn(GB* gb, uint16_t value);
+uint16_t pop_nn(GB* gb);
+void add_a_n(GB* gb, uint8_t value);
+void adc_a_n(GB* gb, uint8_t value);
+void sub_a_n(GB* gb, uint8_t value);
+void sbc_a_n(GB* gb, uint8_t value);
+void and_a_n(GB* gb, uint8_t value);
+void or_a_n(GB* gb, uint8_t value);
+void xor_a_n(GB* gb, uint8_t value);
+void cp_a_n(GB* gb, uint8_t value);
+void inc_n(GB* gb, uint8_t* reg);
+void dec_n(GB* gb, uint8_t* reg);
+void add_hl_n(GB* gb, uint16_t* reg);
+void add_sp_n(GB* gb);
+void inc_nn(GB* gb, uint16_t* reg);
+void dec_nn(GB* gb, uint16_t* reg);
+void swap_n(GB* gb, uint8_t* reg);
+void swap_hl(GB* gb);
+void daa_a(GB* gb);
+void cpl_a(GB* gb);
+void ccf(GB* gb);
+void scf(GB* gb);
+void rl(GB* gb, uint8_t* reg);
+void rrc(GB* gb, uint8_t* reg);
+void rrn(GB* gb, uint8_t* reg);
+void rlc(GB* gb, uint8_t* reg);
+void sla(GB* gb, uint8_t* reg);
+void sra(GB* gb, uint8_t* reg);
+void srl(GB* gb, uint8_t* reg);
+void bit(uint8_t bit, uint8_t* reg, GB* gb);
 void res(uint8_t bit, uint8_t* reg);
 void set(uint8_t bit, uint8_t* reg);
-void jp_nn(CPU* cpu);
-uint8_t jp_cc_nn(CPU* cpu, Condition condition);
-void jp_hl(CPU* cpu);
-void jr_n(CPU* cpu);
-uint8_t jr_cc_n(CPU* cpu, Condition condition);
-void call_nn(CPU* cpu);
-uint8_t call_cc_nn(CPU* cpu, Condition condition);
-void rst_n(CPU* cpu, uint8_t value);
-void ret(CPU* cpu);
-uint8_t ret_cc(CPU* cpu, Condition condition);
-void reti(CPU* cpu);
+void jp_nn(GB* gb);
+uint8_t jp_cc_nn(GB* gb, Condition condition);
+void jp_hl(GB* gb);
+void jr_n(GB* gb);
+uint8_t jr_cc_n(GB* gb, Condition condition);
+void call_nn(GB* gb);
+uint8_t call_cc_nn(GB* gb, Condition condition);
+void rst_n(GB* gb, uint8_t value);
+void ret(GB* gb);
+uint8_t ret_cc(GB* gb, Condition condition);
+void reti(GB* gb);
 
 #endif
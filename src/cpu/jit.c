@@ -0,0 +1,297 @@
+#ifdef JIT
+
+#if !defined(__x86_64__) || !defined(__GNUC__)
+#error "JIT needs an x86-64 target and GCC/Clang"
+#endif
+
+#include "jit.h"
+#include "cpu.h"
+#include "blocks.h"
+#include "instructions.h"
+#include "opcodes.h"
+#include "../memory/memory.h"
+#include "../core/gb.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define JIT_BUFFER_SIZE (4 << 20)
+#define JIT_MAX_BLOCK_BYTES (64 + BLOCK_MAX_OPS * 32)
+
+uint8_t jit_enabled = 1;
+uint8_t jit_verify = 0;
+
+static _Thread_local uint8_t* out;
+
+typedef void (*AluHelper)(GB* gb, uint8_t value);
+static const AluHelper alu_helpers[8] = { add_a_n, adc_a_n, sub_a_n, sbc_a_n, and_a_n, xor_a_n, or_a_n, cp_a_n };
+
+#define OFF_A ((uint8_t)offsetof(GB, cpu.af.A))
+#define OFF_F ((uint8_t)offsetof(GB, cpu.af.F))
+#define OFF_PC ((uint8_t)offsetof(GB, cpu.PC))
+
+// Inline AND/XOR/OR write F directly, which would race a pending lazy result
+#ifdef LAZY_FLAGS
+#define LAZY_JIT 1
+#else
+#define LAZY_JIT 0
+#endif
+
+typedef enum { J_NONE, J_LD_R_R, J_LD_R_N, J_LD_RR_NN, J_ALU_R, J_ALU_N, J_INC_R, J_DEC_R,
+               J_INC_RR, J_DEC_RR, J_CB, J_CALL_HANDLER, J_JR, J_JP, J_JR_CC, J_JP_CC } JitKind;
+
+// Only instructions that never touch memory are compiled, so native code can't
+// see or cause IO side effects and the components can be caught up afterwards
+static JitKind classify(const DecodedOp* op)
+{
+    uint8_t opcode = op->opcode;
+    uint8_t x = opcode >> 6, y = (opcode >> 3) & 7, z = opcode & 7;
+
+    if (x == 1 && opcode != 0x76) return (y != 6 && z != 6) ? J_LD_R_R : J_NONE;
+    if (x == 2) return z != 6 ? J_ALU_R : J_NONE;
+    if (x == 3 && z == 6) return J_ALU_N;
+    if (x == 0 && y != 6 && z == 4) return J_INC_R;
+    if (x == 0 && y != 6 && z == 5) return J_DEC_R;
+    if (x == 0 && y != 6 && z == 6) return J_LD_R_N;
+    if (x == 0 && z == 1 && !(y & 1)) return J_LD_RR_NN;
+    if (x == 0 && z == 3) return (y & 1) ? J_DEC_RR : J_INC_RR;
+
+    switch (opcode)
+    {
+        case 0xCB: return (op->imm & 7) != 6 ? J_CB : J_NONE;
+        case 0x00: case 0x07: case 0x0F: case 0x17: case 0x1F:
+        case 0x27: case 0x2F: case 0x37: case 0x3F:
+        case 0x09: case 0x19: case 0x29: case 0x39: case 0xF9:
+            return J_CALL_HANDLER;
+        case 0x18: return J_JR;
+        case 0xC3: return J_JP;
+        case 0x20: case 0x28: case 0x30: case 0x38: return J_JR_CC;
+        case 0xC2: case 0xCA: case 0xD2: case 0xDA: return J_JP_CC;
+    }
+    return J_NONE;
+}
+
+static void emit8(uint8_t b) { *out++ = b; }
+static void emit16(uint16_t v) { emit8(v); emit8(v >> 8); }
+static void emit32(uint32_t v) { emit16(v); emit16(v >> 16); }
+static void emit64(uint64_t v) { emit32(v); emit32(v >> 32); }
+
+// rbx holds the GB pointer for the whole block, registers live at [rbx + disp8]
+static inline uint8_t reg_offset(GB* gb, const void* reg) { return (uint8_t)((const uint8_t*)reg - (const uint8_t*)gb); }
+
+static void emit_load_al(uint8_t off) { emit8(0x0F); emit8(0xB6); emit8(0x43); emit8(off); }  // movzx eax, byte [rbx+off]
+static void emit_store_al(uint8_t off) { emit8(0x88); emit8(0x43); emit8(off); }              // mov [rbx+off], al
+
+static void emit_call(const void* fn)
+{
+    emit8(0x48); emit8(0x89); emit8(0xDF);                  // mov rdi, rbx
+    emit8(0x48); emit8(0xB8); emit64((uintptr_t)fn);        // mov rax, fn
+    emit8(0xFF); emit8(0xD0);                               // call rax
+}
+
+static void emit_exit(uint16_t pc, uint32_t cycles)
+{
+    emit8(0x66); emit8(0xC7); emit8(0x43); emit8(OFF_PC); emit16(pc);  // mov word [rbx+PC], pc
+    emit8(0xB8); emit32(cycles);                                        // mov eax, cycles
+    emit8(0x5B);                                                        // pop rbx
+    emit8(0xC3);                                                        // ret
+}
+
+// AND/XOR/OR are done inline, the flag result only depends on A
+static void emit_logic(uint8_t alu, uint8_t operand, int immediate)
+{
+    static const uint8_t rm_op[3] = { 0x22, 0x32, 0x0A };   // and/xor/or al, r/m8
+    static const uint8_t imm_op[3] = { 0x24, 0x34, 0x0C };  // and/xor/or al, imm8
+
+    emit_load_al(OFF_A);
+    if (immediate)
+    {
+        emit8(imm_op[alu - 4]); emit8(operand);
+    }
+    else
+    {
+        emit8(rm_op[alu - 4]); emit8(0x43); emit8(operand);
+    }
+    emit_store_al(OFF_A);
+    emit8(0x84); emit8(0xC0);               // test al, al
+    emit8(0x0F); emit8(0x94); emit8(0xC1);  // sete cl
+    emit8(0xC0); emit8(0xE1); emit8(0x07);  // shl cl, 7
+    if (alu == 4)
+    {
+        emit8(0x80); emit8(0xC9); emit8(FLAG_H);  // or cl, H
+    }
+    emit8(0x88); emit8(0x4B); emit8(OFF_F); // mov [rbx+F], cl
+}
+
+static void emit_op(GB* gb, const DecodedOp* op, JitKind kind)
+{
+    uint8_t alu = (op->opcode >> 3) & 7;
+    switch (kind)
+    {
+        case J_LD_R_R:
+            emit_load_al(reg_offset(gb, op->src));
+            emit_store_al(reg_offset(gb, op->dst));
+            break;
+        case J_LD_R_N:
+            emit8(0xC6); emit8(0x43); emit8(reg_offset(gb, op->dst)); emit8(op->imm);
+            break;
+        case J_LD_RR_NN:
+            emit8(0x66); emit8(0xC7); emit8(0x43); emit8(reg_offset(gb, op->pair)); emit16(op->imm);
+            break;
+        case J_INC_RR:
+        case J_DEC_RR:
+            emit8(0x66); emit8(0xFF); emit8(kind == J_INC_RR ? 0x43 : 0x4B); emit8(reg_offset(gb, op->pair));
+            break;
+        case J_ALU_R:
+            if (alu >= 4 && alu <= 6 && !LAZY_JIT)
+            {
+                emit_logic(alu, reg_offset(gb, op->src), 0);
+                break;
+            }
+            emit8(0x0F); emit8(0xB6); emit8(0x73); emit8(reg_offset(gb, op->src));  // movzx esi, byte [rbx+src]
+            emit_call(alu_helpers[alu]);
+            break;
+        case J_ALU_N:
+            if (alu >= 4 && alu <= 6 && !LAZY_JIT)
+            {
+                emit_logic(alu, (uint8_t)op->imm, 1);
+                break;
+            }
+            emit8(0xBE); emit32((uint8_t)op->imm);  // mov esi, imm
+            emit_call(alu_helpers[alu]);
+            break;
+        case J_INC_R:
+        case J_DEC_R:
+            emit8(0x48); emit8(0x8D); emit8(0x73); emit8(reg_offset(gb, op->dst));  // lea rsi, [rbx+reg]
+            emit_call(kind == J_INC_R ? (const void*)inc_n : (const void*)dec_n);
+            break;
+        case J_CB:
+            emit_call(cb_opcodes[op->imm]);
+            break;
+        case J_CALL_HANDLER:
+            emit_call(opcodes[op->opcode]);
+            break;
+        default:
+            break;
+    }
+}
+
+// Closes the block with the branch: one exit for taken, one for not taken
+static uint32_t emit_branch(const DecodedOp* op, JitKind kind, uint32_t cycles)
+{
+    uint32_t taken = cycles + (kind == J_JR || kind == J_JR_CC ? 12 : 16);
+    if (kind == J_JR || kind == J_JP)
+    {
+        emit_exit(op->imm, taken);
+        return taken;
+    }
+
+    uint8_t mask = op->cond <= Z ? FLAG_Z : FLAG_C;
+#ifdef LAZY_FLAGS
+    emit_call(flags_materialize);
+#endif
+    emit8(0xF6); emit8(0x43); emit8(OFF_F); emit8(mask);  // test byte [rbx+F], mask
+    emit8((op->cond & 1) ? 0x74 : 0x75);                  // skip the taken exit when the condition fails
+    emit8(13);
+    emit_exit(op->imm, taken);
+    emit_exit(op->next_pc, cycles + (kind == J_JR_CC ? 8 : 12));
+    return taken;
+}
+
+JitCode* jit_compile(GB* gb, Block* block)
+{
+    JitState* jit = &gb->jit;
+    if (jit->failed) return NULL;
+    if (!jit->buffer)
+    {
+        void* mem = mmap(NULL, JIT_BUFFER_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED)
+        {
+            fprintf(stderr, "Failed to map JIT buffer, running without JIT.\n");
+            jit->failed = 1;
+            return NULL;
+        }
+        jit->buffer = mem;
+    }
+
+    uint8_t count = 0;
+    while (count < block->count && classify(&block->ops[count]) != J_NONE)
+        count++;
+    if (!count) return NULL;
+
+    // Out of space: start over. The blocks holding the old code go with it.
+    if (jit->buffer_used + JIT_MAX_BLOCK_BYTES > JIT_BUFFER_SIZE)
+    {
+        jit->buffer_used = 0;
+        block_cache_flush(gb);
+        return NULL;
+    }
+
+    JitCode* code = (JitCode*)(jit->buffer + jit->buffer_used);
+    out = (uint8_t*)(code + 1);
+    code->fn = (JitFn)(void*)out;
+    code->start = block->start;
+    code->count = count;
+
+    emit8(0x53);                            // push rbx
+    emit8(0x48); emit8(0x89); emit8(0xFB);  // mov rbx, rdi
+
+    uint32_t cycles = 0;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const DecodedOp* op = &block->ops[i];
+        JitKind kind = classify(op);
+        if (kind >= J_JR)
+        {
+            code->max_cycles = emit_branch(op, kind, cycles);
+            break;
+        }
+        emit_op(gb, op, kind);
+        cycles += op->opcode == 0xCB ? cb_opcode_cycles[op->imm] : opcode_cycles[op->opcode];
+        if (i == count - 1)
+        {
+            emit_exit(op->next_pc, cycles);
+            code->max_cycles = cycles;
+        }
+    }
+
+    jit->buffer_used = (uint32_t)(out - jit->buffer + 15) & ~15u;
+    gb->jit.stats.compiled++;
+    return code;
+}
+
+// Lockstep check: replays the block through the interpreter from the CPU state
+// before the native run and stops on the first difference
+void jit_check(GB* gb, const JitCode* code, const CPU* before, uint32_t cycles)
+{
+    CPU native = gb->cpu;
+    gb->cpu = *before;
+    uint32_t expected = 0;
+    for (uint8_t i = 0; i < code->count; i++)
+        expected += opcodes[read_byte(gb, gb->cpu.PC++)](gb);
+
+    if (expected == cycles && memcmp(&gb->cpu, &native, sizeof(CPU)) == 0)
+        return;
+
+    fprintf(stderr, "JIT mismatch in block %04X (%u instructions, %u cycles, interpreter %u)\n",
+            code->start, code->count, cycles, expected);
+    printf("before:      ");
+    print_cpu_state(before);
+    printf("native:      ");
+    print_cpu_state(&native);
+    printf("interpreter: ");
+    print_cpu_state(&gb->cpu);
+    exit(EXIT_FAILURE);
+}
+
+void jit_free(GB* gb)
+{
+    if (gb->jit.buffer) munmap(gb->jit.buffer, JIT_BUFFER_SIZE);
+    gb->jit.buffer = NULL;
+}
+
+#endif
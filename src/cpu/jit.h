@@ -0,0 +1,53 @@
+#ifndef JIT_H
+#define JIT_H
+
+#ifdef JIT
+
+#include <stdint.h>
+#include "cpu.h"
+#include "blocks.h"
+
+#define JIT_HOT_THRESHOLD 32   // block runs before it gets compiled
+
+typedef uint32_t (*JitFn)(GB* gb); // returns cycles taken, leaves PC at the exit
+
+typedef struct JitCode {
+    JitFn fn;
+    uint16_t start;
+    uint16_t max_cycles;   // with the closing branch taken
+    uint8_t count;         // instructions covered
+} JitCode;
+
+typedef struct {
+    uint32_t compiled;
+    uint64_t instructions;  // instructions executed as native code
+} JitStats;
+
+// Per instance: blocks point into their own instance's code buffer
+typedef struct {
+    uint8_t* buffer;
+    uint32_t buffer_used;
+    uint8_t failed;         // couldn't map the buffer, stay on the interpreter
+    JitStats stats;
+} JitState;
+
+extern uint8_t jit_enabled;
+extern uint8_t jit_verify;
+
+JitCode* jit_compile(GB* gb, Block* block);
+void jit_check(GB* gb, const JitCode* code, const CPU* before, uint32_t cycles);
+void jit_free(GB* gb);
+
+// Only ROM blocks get compiled, RAM code can change under us
+static inline JitCode* jit_lookup(GB* gb, Block* block)
+{
+    if (!jit_enabled || block->start >= VRAM_START) return NULL;
+    if (block->native || block->hits == JIT_HOT_THRESHOLD) return block->native;
+    if (++block->hits == JIT_HOT_THRESHOLD)
+        block->native = jit_compile(gb, block);
+    return block->native;
+}
+
+#endif
+
+#endif
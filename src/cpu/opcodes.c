@@ -1,768 +1,824 @@
 #include "opcodes.h"
 #include "cpu.h"
+#include "../core/gb.h"
 #include "instructions.h"
 #include "../memory/memory.h"
 
 // MISC
-static void nop(CPU* cpu) {} // Do nothing
-static void halt(CPU* cpu) 
+static uint8_t nop(GB* gb) { return 4; } // Do nothing
+static uint8_t halt(GB* gb) 
 { 
-    if (!cpu->IME && (memory[ADDR_IF] & memory[ADDR_IE]))
-        cpu->halt_bug = 1; 
+    if (!gb->cpu.IME && (gb->memory[ADDR_IF] & gb->memory[ADDR_IE]))
+        gb->cpu.halt_bug = 1; 
     else
-        cpu->halted = 1;
+        gb->cpu.halted = 1;
+    return 4;
 }
-static void stop(CPU* cpu) 
+static uint8_t stop(GB* gb) 
 { 
-    cpu->stopped = 1; 
-    cpu_timer.div_counter = 0;
-    cpu_timer.tima_counter = 0;
+    gb->cpu.stopped = 1; 
+    gb->timer.div_counter = 0;
+    gb->timer.tima_counter = 0;
+    return 4;
 }
-static void ei(CPU* cpu) { cpu->pending_enable_interrupts = 1; }
-static void di(CPU* cpu) { cpu->pending_disable_interrupts = 0; }
+static uint8_t prefix_cb(GB* gb)
+{
+    uint8_t cb_opcode = read_byte(gb, REG_PC++);
+    return cb_opcodes[cb_opcode](gb);
+}
+static uint8_t ei(GB* gb) { gb->cpu.pending_enable_interrupts = 1; return 4; }
+static uint8_t di(GB* gb) { gb->cpu.pending_disable_interrupts = 0; return 4; }
 
 // LD
-static void ld_bc_u16(CPU* cpu)
+static uint8_t ld_bc_u16(GB* gb)
 {
-    uint8_t low  = read_byte(REG_PC++);
-    uint8_t high = read_byte(REG_PC++);
+    uint8_t low  = read_byte(gb, REG_PC++);
+    uint8_t high = read_byte(gb, REG_PC++);
     REG_BC = (high << 8) | low; // next two bytes into BC reg pair
+    return 12;
 }
-void ld_de_u16(CPU* cpu) 
+uint8_t ld_de_u16(GB* gb) 
 {
-    uint8_t low = read_byte(REG_PC++);
-    uint8_t high = read_byte(REG_PC++);
+    uint8_t low = read_byte(gb, REG_PC++);
+    uint8_t high = read_byte(gb, REG_PC++);
     REG_DE = (high << 8) | low;
+    return 12;
 }
 
-void ld_hl_u16(CPU* cpu) 
+uint8_t ld_hl_u16(GB* gb) 
 {
-    uint8_t low = read_byte(REG_PC++);
-    uint8_t high = read_byte(REG_PC++);
+    uint8_t low = read_byte(gb, REG_PC++);
+    uint8_t high = read_byte(gb, REG_PC++);
     REG_HL = (high << 8) | low;
+    return 12;
 }
 
-void ld_sp_u16(CPU* cpu) 
+uint8_t ld_sp_u16(GB* gb) 
 {
-    uint8_t low = read_byte(REG_PC++);
-    uint8_t high = read_byte(REG_PC++);
+    uint8_t low = read_byte(gb, REG_PC++);
+    uint8_t high = read_byte(gb, REG_PC++);
     REG_SP = (high << 8) | low;
+    return 12;
 }
-static void ld_a_b(CPU* cpu) { ld_rx_ry(cpu, &REG_A, &REG_B); }
-static void load_a_c(CPU* cpu) { ld_a_c(cpu); }
-static void ld_b_c(CPU* cpu) { ld_rx_ry(cpu, &REG_B, &REG_C); }
-static void ld_hl_a(CPU* cpu) { ld_hl_ry(cpu, &REG_A); }
-static void ld_a_d(CPU* cpu) { ld_rx_ry(cpu, &REG_A, &REG_D); }
-static void ld_a_e(CPU* cpu) { ld_rx_ry(cpu, &REG_A, &REG_E); }
-static void ld_a_h(CPU* cpu) { ld_rx_ry(cpu, &REG_A, &REG_H); }
-static void ld_a_l(CPU* cpu) { ld_rx_ry(cpu, &REG_A, &REG_L); }
-static void ld_a_hl(CPU* cpu) { ld_rx_hl(cpu, &REG_A); }
-static void ld_b_a(CPU* cpu) { ld_rx_ry(cpu, &REG_B, &REG_A); }
-static void ld_b_n(CPU* cpu) { ld_r_n(cpu, &REG_B); }
-static void ld_c_n(CPU* cpu) { ld_r_n(cpu, &REG_C); }
-static void ld_d_n(CPU* cpu) { ld_r_n(cpu, &REG_D); }
-static void ld_e_n(CPU* cpu) { ld_r_n(cpu, &REG_E); }
-static void ld_h_n(CPU* cpu) { ld_r_n(cpu, &REG_H); }
-static void ld_l_n(CPU* cpu) { ld_r_n(cpu, &REG_L); }
-static void ld_a_n(CPU* cpu) { ld_r_n(cpu, &REG_A ); }
-static void ld_a_bc(CPU* cpu) { REG_A = read_byte(REG_BC); }
-static void ld_bc_a(CPU* cpu) { write_byte(REG_BC, REG_A); }
-static void ld_a_de(CPU* cpu) { REG_A = read_byte(REG_DE); }
-static void ld_de_a(CPU* cpu) { write_byte(REG_DE, REG_A); }
-static void ld_a_hli(CPU* cpu) { ldi_a_hl(cpu); }
-static void ld_hli_a(CPU* cpu) { ldi_hl_a(cpu); }
-static void ld_a_hld(CPU* cpu) { ldd_a_hl(cpu); }
-static void ld_hld_a(CPU* cpu) { ldd_hl_a(cpu); }
-static void ldh_n_a_op(CPU* cpu) { ldh_n_a(cpu); }
-static void ldh_a_n_op(CPU* cpu) { ldh_a_n(cpu); }
-static void ld_sp_hl_op(CPU* cpu) { ld_sp_hl(cpu); }
-static void ldhl_sp_n_op(CPU* cpu) { ldhl_sp_n(cpu); }
-static void ld_nn_sp_op(CPU* cpu) { ld_nn_sp(cpu); }
-static void ld_a_a(CPU* cpu) { ld_rx_ry(cpu, &REG_A, &REG_A); }
-static void ld_b_b(CPU* cpu) { ld_rx_ry(cpu, &REG_B, &REG_B); }
-static void ld_b_d(CPU* cpu) { ld_rx_ry(cpu, &REG_B, &REG_D); }
-static void ld_b_e(CPU* cpu) { ld_rx_ry(cpu, &REG_B, &REG_E); }
-static void ld_b_h(CPU* cpu) { ld_rx_ry(cpu, &REG_B, &REG_H); }
-static void ld_b_l(CPU* cpu) { ld_rx_ry(cpu, &REG_B, &REG_L); }
-static void ld_c_b(CPU* cpu) { ld_rx_ry(cpu, &REG_C, &REG_B); }
-static void ld_c_c(CPU* cpu) { ld_rx_ry(cpu, &REG_C, &REG_C); }
-static void ld_c_d(CPU* cpu) { ld_rx_ry(cpu, &REG_C, &REG_D); }
-static void ld_c_e(CPU* cpu) { ld_rx_ry(cpu, &REG_C, &REG_E); }
-static void ld_c_h(CPU* cpu) { ld_rx_ry(cpu, &REG_C, &REG_H); }
-static void ld_c_l(CPU* cpu) { ld_rx_ry(cpu, &REG_C, &REG_L); }
-static void ld_d_b(CPU* cpu) { ld_rx_ry(cpu, &REG_D, &REG_B); }
-static void ld_d_c(CPU* cpu) { ld_rx_ry(cpu, &REG_D, &REG_C); }
-static void ld_d_d(CPU* cpu) { ld_rx_ry(cpu, &REG_D, &REG_D); }
-static void ld_d_e(CPU* cpu) { ld_rx_ry(cpu, &REG_D, &REG_E); }
-static void ld_d_h(CPU* cpu) { ld_rx_ry(cpu, &REG_D, &REG_H); }
-static void ld_d_l(CPU* cpu) { ld_rx_ry(cpu, &REG_D, &REG_L); }
-static void ld_d_a(CPU* cpu) { ld_rx_ry(cpu, &REG_D, &REG_A); }
-static void ld_e_b(CPU* cpu) { ld_rx_ry(cpu, &REG_E, &REG_B); }
-static void ld_e_c(CPU* cpu) { ld_rx_ry(cpu, &REG_E, &REG_C); }
-static void ld_e_d(CPU* cpu) { ld_rx_ry(cpu, &REG_E, &REG_D); }
-static void ld_e_e(CPU* cpu) { ld_rx_ry(cpu, &REG_E, &REG_E); }
-static void ld_e_h(CPU* cpu) { ld_rx_ry(cpu, &REG_E, &REG_H); }
-static void ld_e_l(CPU* cpu) { ld_rx_ry(cpu, &REG_E, &REG_L); }
-static void ld_e_a(CPU* cpu) { ld_rx_ry(cpu, &REG_E, &REG_A); }
-static void ld_h_b(CPU* cpu) { ld_rx_ry(cpu, &REG_H, &REG_B); }
-static void ld_h_c(CPU* cpu) { ld_rx_ry(cpu, &REG_H, &REG_C); }
-static void ld_h_d(CPU* cpu) { ld_rx_ry(cpu, &REG_H, &REG_D); }
-static void ld_h_e(CPU* cpu) { ld_rx_ry(cpu, &REG_H, &REG_E); }
-static void ld_h_h(CPU* cpu) { ld_rx_ry(cpu, &REG_H, &REG_H); }
-static void ld_h_l(CPU* cpu) { ld_rx_ry(cpu, &REG_H, &REG_L); }
-static void ld_h_a(CPU* cpu) { ld_rx_ry(cpu, &REG_H, &REG_A); }
-static void ld_l_b(CPU* cpu) { ld_rx_ry(cpu, &REG_L, &REG_B); }
-static void ld_l_c(CPU* cpu) { ld_rx_ry(cpu, &REG_L, &REG_C); }
-static void ld_l_d(CPU* cpu) { ld_rx_ry(cpu, &REG_L, &REG_D); }
-static void ld_l_e(CPU* cpu) { ld_rx_ry(cpu, &REG_L, &REG_E); }
-static void ld_l_h(CPU* cpu) { ld_rx_ry(cpu, &REG_L, &REG_H); }
-static void ld_l_l(CPU* cpu) { ld_rx_ry(cpu, &REG_L, &REG_L); }
-static void ld_l_a(CPU* cpu) { ld_rx_ry(cpu, &REG_L, &REG_A); }
-static void ld_hl_b(CPU* cpu) { ld_hl_ry(cpu, &REG_B); }
-static void ld_hl_c(CPU* cpu) { ld_hl_ry(cpu, &REG_C); }
-static void ld_hl_d(CPU* cpu) { ld_hl_ry(cpu, &REG_D); }
-static void ld_hl_e(CPU* cpu) { ld_hl_ry(cpu, &REG_E); }
-static void ld_hl_h(CPU* cpu) { ld_hl_ry(cpu, &REG_H); }
-static void ld_hl_l(CPU* cpu) { ld_hl_ry(cpu, &REG_L); }
-static void ld_b_hl(CPU* cpu) { ld_rx_hl(cpu, &REG_B); }
-static void ld_c_hl(CPU* cpu) { ld_rx_hl(cpu, &REG_C); }
-static void ld_d_hl(CPU* cpu) { ld_rx_hl(cpu, &REG_D); }
-static void ld_e_hl(CPU* cpu) { ld_rx_hl(cpu, &REG_E); }
-static void ld_h_hl(CPU* cpu) { ld_rx_hl(cpu, &REG_H); }
-static void ld_l_hl(CPU* cpu) { ld_rx_hl(cpu, &REG_L); }
-static void ld_nn_a_op(CPU* cpu) { ld_nn_r(cpu, &REG_A); }
-static void ld_a_nn(CPU* cpu) { ld_r_nn(cpu, &REG_A); }
-static void ld_hl_n(CPU* cpu) {
-    uint8_t value = read_byte(REG_PC++);
-    write_byte(REG_HL, value);
+static uint8_t ld_a_b(GB* gb) { ld_rx_ry(gb, &REG_A, &REG_B); return 4; }
+static uint8_t load_a_c(GB* gb) { ld_rx_ry(gb, &REG_A, &REG_C); return 4; }
+static uint8_t load_c_a(GB* gb) { ld_rx_ry(gb, &REG_C, &REG_A); return 4; }
+static uint8_t ldh_a_c_op(GB* gb) { ld_a_c(gb); return 8; }
+static uint8_t ldh_c_a_op(GB* gb) { ld_c_a(gb); return 8; }
+static uint8_t ld_b_c(GB* gb) { ld_rx_ry(gb, &REG_B, &REG_C); return 4; }
+static uint8_t ld_hl_a(GB* gb) { ld_hl_ry(gb, &REG_A); return 8; }
+static uint8_t ld_a_d(GB* gb) { ld_rx_ry(gb, &REG_A, &REG_D); return 4; }
+static uint8_t ld_a_e(GB* gb) { ld_rx_ry(gb, &REG_A, &REG_E); return 4; }
+static uint8_t ld_a_h(GB* gb) { ld_rx_ry(gb, &REG_A, &REG_H); return 4; }
+static uint8_t ld_a_l(GB* gb) { ld_rx_ry(gb, &REG_A, &REG_L); return 4; }
+static uint8_t ld_a_hl(GB* gb) { ld_rx_hl(gb, &REG_A); return 8; }
+static uint8_t ld_b_a(GB* gb) { ld_rx_ry(gb, &REG_B, &REG_A); return 4; }
+static uint8_t ld_b_n(GB* gb) { ld_r_n(gb, &REG_B); return 8; }
+static uint8_t ld_c_n(GB* gb) { ld_r_n(gb, &REG_C); return 8; }
+static uint8_t ld_d_n(GB* gb) { ld_r_n(gb, &REG_D); return 8; }
+static uint8_t ld_e_n(GB* gb) { ld_r_n(gb, &REG_E); return 8; }
+static uint8_t ld_h_n(GB* gb) { ld_r_n(gb, &REG_H); return 8; }
+static uint8_t ld_l_n(GB* gb) { ld_r_n(gb, &REG_L); return 8; }
+static uint8_t ld_a_n(GB* gb) { ld_r_n(gb, &REG_A ); return 8; }
+static uint8_t ld_a_bc(GB* gb) { REG_A = read_byte(gb, REG_BC); return 8; }
+static uint8_t ld_bc_a(GB* gb) { write_byte(gb, REG_BC, REG_A); return 8; }
+static uint8_t ld_a_de(GB* gb) { REG_A = read_byte(gb, REG_DE); return 8; }
+static uint8_t ld_de_a(GB* gb) { write_byte(gb, REG_DE, REG_A); return 8; }
+static uint8_t ld_a_hli(GB* gb) { ldi_a_hl(gb); return 8; }
+static uint8_t ld_hli_a(GB* gb) { ldi_hl_a(gb); return 8; }
+static uint8_t ld_a_hld(GB* gb) { ldd_a_hl(gb); return 8; }
+static uint8_t ld_hld_a(GB* gb) { ldd_hl_a(gb); return 8; }
+static uint8_t ldh_n_a_op(GB* gb) { ldh_n_a(gb); return 12; }
+static uint8_t ldh_a_n_op(GB* gb) { ldh_a_n(gb); return 12; }
+static uint8_t ld_sp_hl_op(GB* gb) { ld_sp_hl(gb); return 8; }
+static uint8_t ldhl_sp_n_op(GB* gb) { ldhl_sp_n(gb); return 12; }
+static uint8_t ld_nn_sp_op(GB* gb) { ld_nn_sp(gb); return 20; }
+static uint8_t ld_a_a(GB* gb) { ld_rx_ry(gb, &REG_A, &REG_A); return 4; }
+static uint8_t ld_b_b(GB* gb) { ld_rx_ry(gb, &REG_B, &REG_B); return 4; }
+static uint8_t ld_b_d(GB* gb) { ld_rx_ry(gb, &REG_B, &REG_D); return 4; }
+static uint8_t ld_b_e(GB* gb) { ld_rx_ry(gb, &REG_B, &REG_E); return 4; }
+static uint8_t ld_b_h(GB* gb) { ld_rx_ry(gb, &REG_B, &REG_H); return 4; }
+static uint8_t ld_b_l(GB* gb) { ld_rx_ry(gb, &REG_B, &REG_L); return 4; }
+static uint8_t ld_c_b(GB* gb) { ld_rx_ry(gb, &REG_C, &REG_B); return 4; }
+static uint8_t ld_c_c(GB* gb) { ld_rx_ry(gb, &REG_C, &REG_C); return 4; }
+static uint8_t ld_c_d(GB* gb) { ld_rx_ry(gb, &REG_C, &REG_D); return 4; }
+static uint8_t ld_c_e(GB* gb) { ld_rx_ry(gb, &REG_C, &REG_E); return 4; }
+static uint8_t ld_c_h(GB* gb) { ld_rx_ry(gb, &REG_C, &REG_H); return 4; }
+static uint8_t ld_c_l(GB* gb) { ld_rx_ry(gb, &REG_C, &REG_L); return 4; }
+static uint8_t ld_d_b(GB* gb) { ld_rx_ry(gb, &REG_D, &REG_B); return 4; }
+static uint8_t ld_d_c(GB* gb) { ld_rx_ry(gb, &REG_D, &REG_C); return 4; }
+static uint8_t ld_d_d(GB* gb) { ld_rx_ry(gb, &REG_D, &REG_D); return 4; }
+static uint8_t ld_d_e(GB* gb) { ld_rx_ry(gb, &REG_D, &REG_E); return 4; }
+static uint8_t ld_d_h(GB* gb) { ld_rx_ry(gb, &REG_D, &REG_H); return 4; }
+static uint8_t ld_d_l(GB* gb) { ld_rx_ry(gb, &REG_D, &REG_L); return 4; }
+static uint8_t ld_d_a(GB* gb) { ld_rx_ry(gb, &REG_D, &REG_A); return 4; }
+static uint8_t ld_e_b(GB* gb) { ld_rx_ry(gb, &REG_E, &REG_B); return 4; }
+static uint8_t ld_e_c(GB* gb) { ld_rx_ry(gb, &REG_E, &REG_C); return 4; }
+static uint8_t ld_e_d(GB* gb) { ld_rx_ry(gb, &REG_E, &REG_D); return 4; }
+static uint8_t ld_e_e(GB* gb) { ld_rx_ry(gb, &REG_E, &REG_E); return 4; }
+static uint8_t ld_e_h(GB* gb) { ld_rx_ry(gb, &REG_E, &REG_H); return 4; }
+static uint8_t ld_e_l(GB* gb) { ld_rx_ry(gb, &REG_E, &REG_L); return 4; }
+static uint8_t ld_e_a(GB* gb) { ld_rx_ry(gb, &REG_E, &REG_A); return 4; }
+static uint8_t ld_h_b(GB* gb) { ld_rx_ry(gb, &REG_H, &REG_B); return 4; }
+static uint8_t ld_h_c(GB* gb) { ld_rx_ry(gb, &REG_H, &REG_C); return 4; }
+static uint8_t ld_h_d(GB* gb) { ld_rx_ry(gb, &REG_H, &REG_D); return 4; }
+static uint8_t ld_h_e(GB* gb) { ld_rx_ry(gb, &REG_H, &REG_E); return 4; }
+static uint8_t ld_h_h(GB* gb) { ld_rx_ry(gb, &REG_H, &REG_H); return 4; }
+static uint8_t ld_h_l(GB* gb) { ld_rx_ry(gb, &REG_H, &REG_L); return 4; }
+static uint8_t ld_h_a(GB* gb) { ld_rx_ry(gb, &REG_H, &REG_A); return 4; }
+static uint8_t ld_l_b(GB* gb) { ld_rx_ry(gb, &REG_L, &REG_B); return 4; }
+static uint8_t ld_l_c(GB* gb) { ld_rx_ry(gb, &REG_L, &REG_C); return 4; }
+static uint8_t ld_l_d(GB* gb) { ld_rx_ry(gb, &REG_L, &REG_D); return 4; }
+static uint8_t ld_l_e(GB* gb) { ld_rx_ry(gb, &REG_L, &REG_E); return 4; }
+static uint8_t ld_l_h(GB* gb) { ld_rx_ry(gb, &REG_L, &REG_H); return 4; }
+static uint8_t ld_l_l(GB* gb) { ld_rx_ry(gb, &REG_L, &REG_L); return 4; }
+static uint8_t ld_l_a(GB* gb) { ld_rx_ry(gb, &REG_L, &REG_A); return 4; }
+static uint8_t ld_hl_b(GB* gb) { ld_hl_ry(gb, &REG_B); return 8; }
+static uint8_t ld_hl_c(GB* gb) { ld_hl_ry(gb, &REG_C); return 8; }
+static uint8_t ld_hl_d(GB* gb) { ld_hl_ry(gb, &REG_D); return 8; }
+static uint8_t ld_hl_e(GB* gb) { ld_hl_ry(gb, &REG_E); return 8; }
+static uint8_t ld_hl_h(GB* gb) { ld_hl_ry(gb, &REG_H); return 8; }
+static uint8_t ld_hl_l(GB* gb) { ld_hl_ry(gb, &REG_L); return 8; }
+static uint8_t ld_b_hl(GB* gb) { ld_rx_hl(gb, &REG_B); return 8; }
+static uint8_t ld_c_hl(GB* gb) { ld_rx_hl(gb, &REG_C); return 8; }
+static uint8_t ld_d_hl(GB* gb) { ld_rx_hl(gb, &REG_D); return 8; }
+static uint8_t ld_e_hl(GB* gb) { ld_rx_hl(gb, &REG_E); return 8; }
+static uint8_t ld_h_hl(GB* gb) { ld_rx_hl(gb, &REG_H); return 8; }
+static uint8_t ld_l_hl(GB* gb) { ld_rx_hl(gb, &REG_L); return 8; }
+static uint8_t ld_nn_a_op(GB* gb) { ld_nn_r(gb, &REG_A); return 16; }
+static uint8_t ld_a_nn(GB* gb) { ld_r_nn(gb, &REG_A); return 16; }
+static uint8_t ld_hl_n(GB* gb) {
+    uint8_t value = read_byte(gb, REG_PC++);
+    write_byte(gb, REG_HL, value);
+    return 12;
 }
 // ADD
-static void add_a_b(CPU* cpu) { add_a_n(cpu, REG_B); }
-static void add_a_c(CPU* cpu) { add_a_n(cpu, REG_C); }
-static void add_a_d(CPU* cpu) { add_a_n(cpu, REG_D); }
-static void add_a_e(CPU* cpu) { add_a_n(cpu, REG_E); }
-static void add_a_h(CPU* cpu) { add_a_n(cpu, REG_H); }
-static void add_a_l(CPU* cpu) { add_a_n(cpu, REG_L); }
-static void add_a_hl(CPU* cpu) { add_a_n(cpu, read_byte(REG_HL)); }
-static void add_a_a(CPU* cpu) { add_a_n(cpu, REG_A); }
-static void add_hl_bc(CPU* cpu) { add_hl_n(cpu, &REG_BC); }
-static void add_hl_de(CPU* cpu) { add_hl_n(cpu, &REG_DE); }
-static void add_hl_hl(CPU* cpu) { add_hl_n(cpu, &REG_HL); }
-static void add_hl_sp(CPU* cpu) { add_hl_n(cpu, &REG_SP); }
-static void adc_a_b(CPU* cpu) { adc_a_n(cpu, REG_B); }
-static void adc_a_c(CPU* cpu) { adc_a_n(cpu, REG_C); }
-static void adc_a_d(CPU* cpu) { adc_a_n(cpu, REG_D); }
-static void adc_a_e(CPU* cpu) { adc_a_n(cpu, REG_E); }
-static void adc_a_h(CPU* cpu) { adc_a_n(cpu, REG_H); }
-static void adc_a_l(CPU* cpu) { adc_a_n(cpu, REG_L); }
-static void adc_a_hl(CPU* cpu) { adc_a_n(cpu, read_byte(REG_HL)); }
-static void adc_a_a(CPU* cpu) { adc_a_n(cpu, REG_A); }
+static uint8_t add_a_b(GB* gb) { add_a_n(gb, REG_B); return 4; }
+static uint8_t add_a_c(GB* gb) { add_a_n(gb, REG_C); return 4; }
+static uint8_t add_a_d(GB* gb) { add_a_n(gb, REG_D); return 4; }
+static uint8_t add_a_e(GB* gb) { add_a_n(gb, REG_E); return 4; }
+static uint8_t add_a_h(GB* gb) { add_a_n(gb, REG_H); return 4; }
+static uint8_t add_a_l(GB* gb) { add_a_n(gb, REG_L); return 4; }
+static uint8_t add_a_hl(GB* gb) { add_a_n(gb, read_byte(gb, REG_HL)); return 8; }
+static uint8_t add_a_a(GB* gb) { add_a_n(gb, REG_A); return 4; }
+static uint8_t add_hl_bc(GB* gb) { add_hl_n(gb, &REG_BC); return 8; }
+static uint8_t add_hl_de(GB* gb) { add_hl_n(gb, &REG_DE); return 8; }
+static uint8_t add_hl_hl(GB* gb) { add_hl_n(gb, &REG_HL); return 8; }
+static uint8_t add_hl_sp(GB* gb) { add_hl_n(gb, &REG_SP); return 8; }
+static uint8_t adc_a_b(GB* gb) { adc_a_n(gb, REG_B); return 4; }
+static uint8_t adc_a_c(GB* gb) { adc_a_n(gb, REG_C); return 4; }
+static uint8_t adc_a_d(GB* gb) { adc_a_n(gb, REG_D); return 4; }
+static uint8_t adc_a_e(GB* gb) { adc_a_n(gb, REG_E); return 4; }
+static uint8_t adc_a_h(GB* gb) { adc_a_n(gb, REG_H); return 4; }
+static uint8_t adc_a_l(GB* gb) { adc_a_n(gb, REG_L); return 4; }
+static uint8_t adc_a_hl(GB* gb) { adc_a_n(gb, read_byte(gb, REG_HL)); return 8; }
+static uint8_t adc_a_a(GB* gb) { adc_a_n(gb, REG_A); return 4; }
 // SUB
-static void sub_a_b(CPU* cpu) { sub_a_n(cpu, REG_B); }
-static void sub_a_c(CPU* cpu) { sub_a_n(cpu, REG_C); }
-static void sub_a_d(CPU* cpu) { sub_a_n(cpu, REG_D); }
-static void sub_a_e(CPU* cpu) { sub_a_n(cpu, REG_E); }
-static void sub_a_h(CPU* cpu) { sub_a_n(cpu, REG_H); }
-static void sub_a_l(CPU* cpu) { sub_a_n(cpu, REG_L); }
-static void sub_a_hl(CPU* cpu) { sub_a_n(cpu, read_byte(REG_HL)); }
-static void sub_a_a(CPU* cpu) { sub_a_n(cpu, REG_A); }
-static void sbc_a_b(CPU* cpu) { sbc_a_n(cpu, REG_B); }
-static void sbc_a_c(CPU* cpu) { sbc_a_n(cpu, REG_C); }
-static void sbc_a_d(CPU* cpu) { sbc_a_n(cpu, REG_D); }
-static void sbc_a_e(CPU* cpu) { sbc_a_n(cpu, REG_E); }
-static void sbc_a_h(CPU* cpu) { sbc_a_n(cpu, REG_H); }
-static void sbc_a_l(CPU* cpu) { sbc_a_n(cpu, REG_L); }
-static void sbc_a_hl(CPU* cpu) { sbc_a_n(cpu, read_byte(REG_HL)); }
-static void sbc_a_a(CPU* cpu) { sbc_a_n(cpu, REG_A); }
+static uint8_t sub_a_b(GB* gb) { sub_a_n(gb, REG_B); return 4; }
+static uint8_t sub_a_c(GB* gb) { sub_a_n(gb, REG_C); return 4; }
+static uint8_t sub_a_d(GB* gb) { sub_a_n(gb, REG_D); return 4; }
+static uint8_t sub_a_e(GB* gb) { sub_a_n(gb, REG_E); return 4; }
+static uint8_t sub_a_h(GB* gb) { sub_a_n(gb, REG_H); return 4; }
+static uint8_t sub_a_l(GB* gb) { sub_a_n(gb, REG_L); return 4; }
+static uint8_t sub_a_hl(GB* gb) { sub_a_n(gb, read_byte(gb, REG_HL)); return 8; }
+static uint8_t sub_a_a(GB* gb) { sub_a_n(gb, REG_A); return 4; }
+static uint8_t sbc_a_b(GB* gb) { sbc_a_n(gb, REG_B); return 4; }
+static uint8_t sbc_a_c(GB* gb) { sbc_a_n(gb, REG_C); return 4; }
+static uint8_t sbc_a_d(GB* gb) { sbc_a_n(gb, REG_D); return 4; }
+static uint8_t sbc_a_e(GB* gb) { sbc_a_n(gb, REG_E); return 4; }
+static uint8_t sbc_a_h(GB* gb) { sbc_a_n(gb, REG_H); return 4; }
+static uint8_t sbc_a_l(GB* gb) { sbc_a_n(gb, REG_L); return 4; }
+static uint8_t sbc_a_hl(GB* gb) { sbc_a_n(gb, read_byte(gb, REG_HL)); return 8; }
+static uint8_t sbc_a_a(GB* gb) { sbc_a_n(gb, REG_A); return 4; }
 // INC
-static void inc_b(CPU* cpu) { inc_n(cpu, &REG_B); }
-static void inc_c(CPU* cpu) { inc_n(cpu, &REG_C); }
-static void inc_d(CPU* cpu) { inc_n(cpu, &REG_D); }
-static void inc_e(CPU* cpu) { inc_n(cpu, &REG_E); }
-static void inc_h(CPU* cpu) { inc_n(cpu, &REG_H); }
-static void inc_l(CPU* cpu) { inc_n(cpu, &REG_L); }
-static void inc_a(CPU* cpu) { inc_n(cpu, &REG_A); }
-static void inc_hl8(CPU* cpu) { 
-    uint8_t value = read_byte(REG_HL);
-    inc_n(cpu, &value);
-    write_byte(REG_HL, value);
+static uint8_t inc_b(GB* gb) { inc_n(gb, &REG_B); return 4; }
+static uint8_t inc_c(GB* gb) { inc_n(gb, &REG_C); return 4; }
+static uint8_t inc_d(GB* gb) { inc_n(gb, &REG_D); return 4; }
+static uint8_t inc_e(GB* gb) { inc_n(gb, &REG_E); return 4; }
+static uint8_t inc_h(GB* gb) { inc_n(gb, &REG_H); return 4; }
+static uint8_t inc_l(GB* gb) { inc_n(gb, &REG_L); return 4; }
+static uint8_t inc_a(GB* gb) { inc_n(gb, &REG_A); return 4; }
+static uint8_t inc_hl8(GB* gb) { 
+    uint8_t value = read_byte(gb, REG_HL);
+    inc_n(gb, &value);
+    write_byte(gb, REG_HL, value);
+    return 12;
 }
-static void inc_bc(CPU* cpu) { inc_nn(cpu, &REG_BC); }
-static void inc_de(CPU* cpu) { inc_nn(cpu, &REG_DE); }
-static void inc_hl(CPU* cpu) { inc_nn(cpu, &REG_HL); }
-static void inc_sp(CPU* cpu) { inc_nn(cpu, &REG_SP); }
+static uint8_t inc_bc(GB* gb) { inc_nn(gb, &REG_BC); return 8; }
+static uint8_t inc_de(GB* gb) { inc_nn(gb, &REG_DE); return 8; }
+static uint8_t inc_hl(GB* gb) { inc_nn(gb, &REG_HL); return 8; }
+static uint8_t inc_sp(GB* gb) { inc_nn(gb, &REG_SP); return 8; }
 // DEC
-static void dec_b(CPU* cpu) { dec_n(cpu, &REG_B); }
-static void dec_c(CPU* cpu) { dec_n(cpu, &REG_C); }
-static void dec_d(CPU* cpu) { dec_n(cpu, &REG_D); }
-static void dec_e(CPU* cpu) { dec_n(cpu, &REG_E); }
-static void dec_h(CPU* cpu) { dec_n(cpu, &REG_H); }
-static void dec_l(CPU* cpu) { dec_n(cpu, &REG_L); }
-static void dec_a(CPU* cpu) { dec_n(cpu, &REG_A); }
-static void dec_hl8(CPU* cpu) { 
-    uint8_t value = read_byte(REG_HL);
-    dec_n(cpu, &value);
-    write_byte(REG_HL, value);
+static uint8_t dec_b(GB* gb) { dec_n(gb, &REG_B); return 4; }
+static uint8_t dec_c(GB* gb) { dec_n(gb, &REG_C); return 4; }
+static uint8_t dec_d(GB* gb) { dec_n(gb, &REG_D); return 4; }
+static uint8_t dec_e(GB* gb) { dec_n(gb, &REG_E); return 4; }
+static uint8_t dec_h(GB* gb) { dec_n(gb, &REG_H); return 4; }
+static uint8_t dec_l(GB* gb) { dec_n(gb, &REG_L); return 4; }
+static uint8_t dec_a(GB* gb) { dec_n(gb, &REG_A); return 4; }
+static uint8_t dec_hl8(GB* gb) { 
+    uint8_t value = read_byte(gb, REG_HL);
+    dec_n(gb, &value);
+    write_byte(gb, REG_HL, value);
+    return 12;
 }
-static void dec_bc(CPU* cpu) { dec_nn(cpu, &REG_BC); }
-static void dec_de(CPU* cpu) { dec_nn(cpu, &REG_DE); }
-static void dec_hl(CPU* cpu) { dec_nn(cpu, &REG_HL); }
-static void dec_sp(CPU* cpu) { dec_nn(cpu, &REG_SP); }
+static uint8_t dec_bc(GB* gb) { dec_nn(gb, &REG_BC); return 8; }
+static uint8_t dec_de(GB* gb) { dec_nn(gb, &REG_DE); return 8; }
+static uint8_t dec_hl(GB* gb) { dec_nn(gb, &REG_HL); return 8; }
+static uint8_t dec_sp(GB* gb) { dec_nn(gb, &REG_SP); return 8; }
 // PUSH
-static void push_bc(CPU* cpu) { push_nn(cpu, REG_BC); }
-static void push_de(CPU* cpu) { push_nn(cpu, REG_DE); }
-static void push_hl(CPU* cpu) { push_nn(cpu, REG_HL); }
-static void push_af(CPU* cpu) { push_nn(cpu, REG_AF & 0xFFF0); } // lower 4 bits of F are always 0
+static uint8_t push_bc(GB* gb) { push_nn(gb, REG_BC); return 16; }
+static uint8_t push_de(GB* gb) { push_nn(gb, REG_DE); return 16; }
+static uint8_t push_hl(GB* gb) { push_nn(gb, REG_HL); return 16; }
+static uint8_t push_af(GB* gb) { FLAGS_SYNC(gb); push_nn(gb, REG_AF & 0xFFF0); return 16; } // lower 4 bits of F are always 0
 // POP
-static void pop_bc(CPU* cpu) { REG_BC = pop_nn(cpu); }
-static void pop_de(CPU* cpu) { REG_DE = pop_nn(cpu); }
-static void pop_hl(CPU* cpu) { REG_HL = pop_nn(cpu); }
-static void pop_af(CPU* cpu) { REG_AF = pop_nn(cpu) & 0xFFF0; } // lower 4 bits of F always 0
+static uint8_t pop_bc(GB* gb) { REG_BC = pop_nn(gb); return 12; }
+static uint8_t pop_de(GB* gb) { REG_DE = pop_nn(gb); return 12; }
+static uint8_t pop_hl(GB* gb) { REG_HL = pop_nn(gb); return 12; }
+static uint8_t pop_af(GB* gb) { FLAGS_DROP(gb); REG_AF = pop_nn(gb) & 0xFFF0; return 12; } // lower 4 bits of F always 0
 // AND
-static void and_a_b(CPU* cpu) { and_a_n(cpu, REG_B); }
-static void and_a_c(CPU* cpu) { and_a_n(cpu, REG_C); }
-static void and_a_d(CPU* cpu) { and_a_n(cpu, REG_D); }
-static void and_a_e(CPU* cpu) { and_a_n(cpu, REG_E); }
-static void and_a_h(CPU* cpu) { and_a_n(cpu, REG_H); }
-static void and_a_l(CPU* cpu) { and_a_n(cpu, REG_L); }
-static void and_a_hl(CPU* cpu) { and_a_n(cpu, read_byte(REG_HL)); }
-static void and_a_a(CPU* cpu) { and_a_n(cpu, REG_A); }
+static uint8_t and_a_b(GB* gb) { and_a_n(gb, REG_B); return 4; }
+static uint8_t and_a_c(GB* gb) { and_a_n(gb, REG_C); return 4; }
+static uint8_t and_a_d(GB* gb) { and_a_n(gb, REG_D); return 4; }
+static uint8_t and_a_e(GB* gb) { and_a_n(gb, REG_E); return 4; }
+static uint8_t and_a_h(GB* gb) { and_a_n(gb, REG_H); return 4; }
+static uint8_t and_a_l(GB* gb) { and_a_n(gb, REG_L); return 4; }
+static uint8_t and_a_hl(GB* gb) { and_a_n(gb, read_byte(gb, REG_HL)); return 8; }
+static uint8_t and_a_a(GB* gb) { and_a_n(gb, REG_A); return 4; }
 // OR
-static void or_a_b(CPU* cpu) { or_a_n(cpu, REG_B); }
-static void or_a_c(CPU* cpu) { or_a_n(cpu, REG_C); }
-static void or_a_d(CPU* cpu) { or_a_n(cpu, REG_D); }
-static void or_a_e(CPU* cpu) { or_a_n(cpu, REG_E); }
-static void or_a_h(CPU* cpu) { or_a_n(cpu, REG_H); }
-static void or_a_l(CPU* cpu) { or_a_n(cpu, REG_L); }
-static void or_a_hl(CPU* cpu) { or_a_n(cpu, read_byte(REG_HL)); }
-static void or_a_a(CPU* cpu) { or_a_n(cpu, REG_A); }
+static uint8_t or_a_b(GB* gb) { or_a_n(gb, REG_B); return 4; }
+static uint8_t or_a_c(GB* gb) { or_a_n(gb, REG_C); return 4; }
+static uint8_t or_a_d(GB* gb) { or_a_n(gb, REG_D); return 4; }
+static uint8_t or_a_e(GB* gb) { or_a_n(gb, REG_E); return 4; }
+static uint8_t or_a_h(GB* gb) { or_a_n(gb, REG_H); return 4; }
+static uint8_t or_a_l(GB* gb) { or_a_n(gb, REG_L); return 4; }
+static uint8_t or_a_hl(GB* gb) { or_a_n(gb, read_byte(gb, REG_HL)); return 8; }
+static uint8_t or_a_a(GB* gb) { or_a_n(gb, REG_A); return 4; }
 // XOR
-static void xor_a_b(CPU* cpu) { xor_a_n(cpu, REG_B); }
-static void xor_a_c(CPU* cpu) { xor_a_n(cpu, REG_C); }
-static void xor_a_d(CPU* cpu) { xor_a_n(cpu, REG_D); }
-static void xor_a_e(CPU* cpu) { xor_a_n(cpu, REG_E); }
-static void xor_a_h(CPU* cpu) { xor_a_n(cpu, REG_H); }
-static void xor_a_l(CPU* cpu) { xor_a_n(cpu, REG_L); }
-static void xor_a_hl(CPU* cpu) { xor_a_n(cpu, read_byte(REG_HL)); }
-static void xor_a_a(CPU* cpu) { xor_a_n(cpu, REG_A); }
+static uint8_t xor_a_b(GB* gb) { xor_a_n(gb, REG_B); return 4; }
+static uint8_t xor_a_c(GB* gb) { xor_a_n(gb, REG_C); return 4; }
+static uint8_t xor_a_d(GB* gb) { xor_a_n(gb, REG_D); return 4; }
+static uint8_t xor_a_e(GB* gb) { xor_a_n(gb, REG_E); return 4; }
+static uint8_t xor_a_h(GB* gb) { xor_a_n(gb, REG_H); return 4; }
+static uint8_t xor_a_l(GB* gb) { xor_a_n(gb, REG_L); return 4; }
+static uint8_t xor_a_hl(GB* gb) { xor_a_n(gb, read_byte(gb, REG_HL)); return 8; }
+static uint8_t xor_a_a(GB* gb) { xor_a_n(gb, REG_A); return 4; }
 // CP
-static void cp_a_b(CPU* cpu) { cp_a_n(cpu, REG_B); }
-static void cp_a_c(CPU* cpu) { cp_a_n(cpu, REG_C); }
-static void cp_a_d(CPU* cpu) { cp_a_n(cpu, REG_D); }
-static void cp_a_e(CPU* cpu) { cp_a_n(cpu, REG_E); }
-static void cp_a_h(CPU* cpu) { cp_a_n(cpu, REG_H); }
-static void cp_a_l(CPU* cpu) { cp_a_n(cpu, REG_L); }
-static void cp_a_hl(CPU* cpu) { cp_a_n(cpu, read_byte(REG_HL)); }
-static void cp_a_a(CPU* cpu) { cp_a_n(cpu, REG_A); }
-static void cp_a_imm(CPU* cpu) 
+static uint8_t cp_a_b(GB* gb) { cp_a_n(gb, REG_B); return 4; }
+static uint8_t cp_a_c(GB* gb) { cp_a_n(gb, REG_C); return 4; }
+static uint8_t cp_a_d(GB* gb) { cp_a_n(gb, REG_D); return 4; }
+static uint8_t cp_a_e(GB* gb) { cp_a_n(gb, REG_E); return 4; }
+static uint8_t cp_a_h(GB* gb) { cp_a_n(gb, REG_H); return 4; }
+static uint8_t cp_a_l(GB* gb) { cp_a_n(gb, REG_L); return 4; }
+static uint8_t cp_a_hl(GB* gb) { cp_a_n(gb, read_byte(gb, REG_HL)); return 8; }
+static uint8_t cp_a_a(GB* gb) { cp_a_n(gb, REG_A); return 4; }
+static uint8_t cp_a_imm(GB* gb) 
 {
-    uint8_t value = read_byte(REG_PC++);
-    cp_a_n(cpu, value);
+    uint8_t value = read_byte(gb, REG_PC++);
+    cp_a_n(gb, value);
+    return 8;
 }
 // SWAP
-static void swap_a(CPU* cpu) { swap_n(cpu, &REG_A); }
-static void swap_b(CPU* cpu) { swap_n(cpu, &REG_B); }
-static void swap_c(CPU* cpu) { swap_n(cpu, &REG_C); }
-static void swap_d(CPU* cpu) { swap_n(cpu, &REG_D); }
-static void swap_e(CPU* cpu) { swap_n(cpu, &REG_E); }
-static void swap_h(CPU* cpu) { swap_n(cpu, &REG_H); }
-static void swap_l(CPU* cpu) { swap_n(cpu, &REG_L); }
-static void swap_hlp(CPU* cpu) { swap_hl(cpu); }
+static uint8_t swap_a(GB* gb) { swap_n(gb, &REG_A); return 8; }
+static uint8_t swap_b(GB* gb) { swap_n(gb, &REG_B); return 8; }
+static uint8_t swap_c(GB* gb) { swap_n(gb, &REG_C); return 8; }
+static uint8_t swap_d(GB* gb) { swap_n(gb, &REG_D); return 8; }
+static uint8_t swap_e(GB* gb) { swap_n(gb, &REG_E); return 8; }
+static uint8_t swap_h(GB* gb) { swap_n(gb, &REG_H); return 8; }
+static uint8_t swap_l(GB* gb) { swap_n(gb, &REG_L); return 8; }
+static uint8_t swap_hlp(GB* gb) { swap_hl(gb); return 16; }
 // DAA
-static void op_daa(CPU* cpu) { daa_a(cpu); }
+static uint8_t op_daa(GB* gb) { daa_a(gb); return 4; }
 // CARRY
-static void op_cpl(CPU* cpu) { cpl_a(cpu); }
-static void op_ccf(CPU* cpu) { ccf(cpu); }
-static void op_scf(CPU* cpu) { scf(cpu); }
+static uint8_t op_cpl(GB* gb) { cpl_a(gb); return 4; }
+static uint8_t op_ccf(GB* gb) { ccf(gb); return 4; }
+static uint8_t op_scf(GB* gb) { scf(gb); return 4; }
 // ROTATE
-static void rlc_a(CPU* cpu) { rlc(cpu, &REG_A); }
-static void rlc_b(CPU* cpu) { rlc(cpu, &REG_B); }
-static void rlc_c(CPU* cpu) { rlc(cpu, &REG_C); }
-static void rlc_d(CPU* cpu) { rlc(cpu, &REG_D); }
-static void rlc_e(CPU* cpu) { rlc(cpu, &REG_E); }
-static void rlc_h(CPU* cpu) { rlc(cpu, &REG_H); }
-static void rlc_l(CPU* cpu) { rlc(cpu, &REG_L); }
-static void rlc_hlp(CPU* cpu)
+static uint8_t rlc_a(GB* gb) { rlc(gb, &REG_A); return 8; }
+static uint8_t rlc_b(GB* gb) { rlc(gb, &REG_B); return 8; }
+static uint8_t rlc_c(GB* gb) { rlc(gb, &REG_C); return 8; }
+static uint8_t rlc_d(GB* gb) { rlc(gb, &REG_D); return 8; }
+static uint8_t rlc_e(GB* gb) { rlc(gb, &REG_E); return 8; }
+static uint8_t rlc_h(GB* gb) { rlc(gb, &REG_H); return 8; }
+static uint8_t rlc_l(GB* gb) { rlc(gb, &REG_L); return 8; }
+static uint8_t rlc_hlp(GB* gb)
 { 
-    uint8_t value = read_byte(REG_HL);
-    rlc(cpu, &value);
-    write_byte(REG_HL, value);
+    uint8_t value = read_byte(gb, REG_HL);
+    rlc(gb, &value);
+    write_byte(gb, REG_HL, value);
+    return 16;
 }
-static void rl_hlp(CPU* cpu)
+static uint8_t rl_hlp(GB* gb)
 {
-    uint8_t value = read_byte(REG_HL);
-    rl(cpu, &value);
-    write_byte(REG_HL, value);
+    uint8_t value = read_byte(gb, REG_HL);
+    rl(gb, &value);
+    write_byte(gb, REG_HL, value);
+    return 16;
 }
-static void rl_a(CPU* cpu) { rl(cpu, &REG_A); }
-static void rl_b(CPU* cpu) { rl(cpu, &REG_B); }
-static void rl_c(CPU* cpu) { rl(cpu, &REG_C); }
-static void rl_d(CPU* cpu) { rl(cpu, &REG_D); }
-static void rl_e(CPU* cpu) { rl(cpu, &REG_E); }
-static void rl_h(CPU* cpu) { rl(cpu, &REG_H); }
-static void rl_l(CPU* cpu) { rl(cpu, &REG_L); }
-static void rrc_a(CPU* cpu) { rrc(cpu, &REG_A); }
-static void rrc_b(CPU* cpu) { rrc(cpu, &REG_B); }
-static void rrc_c(CPU* cpu) { rrc(cpu, &REG_C); }
-static void rrc_d(CPU* cpu) { rrc(cpu, &REG_D); }
-static void rrc_e(CPU* cpu) { rrc(cpu, &REG_E); }
-static void rrc_h(CPU* cpu) { rrc(cpu, &REG_H); }
-static void rrc_l(CPU* cpu) { rrc(cpu, &REG_L); }
-static void rrc_hlp(CPU* cpu)
+static uint8_t rl_a(GB* gb) { rl(gb, &REG_A); return 8; }
+static uint8_t rl_b(GB* gb) { rl(gb, &REG_B); return 8; }
+static uint8_t rl_c(GB* gb) { rl(gb, &REG_C); return 8; }
+static uint8_t rl_d(GB* gb) { rl(gb, &REG_D); return 8; }
+static uint8_t rl_e(GB* gb) { rl(gb, &REG_E); return 8; }
+static uint8_t rl_h(GB* gb) { rl(gb, &REG_H); return 8; }
+static uint8_t rl_l(GB* gb) { rl(gb, &REG_L); return 8; }
+static uint8_t rrc_a(GB* gb) { rrc(gb, &REG_A); return 8; }
+static uint8_t rrc_b(GB* gb) { rrc(gb, &REG_B); return 8; }
+static uint8_t rrc_c(GB* gb) { rrc(gb, &REG_C); return 8; }
+static uint8_t rrc_d(GB* gb) { rrc(gb, &REG_D); return 8; }
+static uint8_t rrc_e(GB* gb) { rrc(gb, &REG_E); return 8; }
+static uint8_t rrc_h(GB* gb) { rrc(gb, &REG_H); return 8; }
+static uint8_t rrc_l(GB* gb) { rrc(gb, &REG_L); return 8; }
+static uint8_t rrc_hlp(GB* gb)
 {
-    uint8_t value = read_byte(REG_HL);
-    rrc(cpu, &value);
-    write_byte(REG_HL, value);
+    uint8_t value = read_byte(gb, REG_HL);
+    rrc(gb, &value);
+    write_byte(gb, REG_HL, value);
+    return 16;
 }
-static void rr_a(CPU* cpu) { rrn(cpu, &REG_A); }
-static void rr_b(CPU* cpu) { rrn(cpu, &REG_B); }
-static void rr_c(CPU* cpu) { rrn(cpu, &REG_C); }
-static void rr_d(CPU* cpu) { rrn(cpu, &REG_D); }
-static void rr_e(CPU* cpu) { rrn(cpu, &REG_E); }
-static void rr_h(CPU* cpu) { rrn(cpu, &REG_H); }
-static void rr_l(CPU* cpu) { rrn(cpu, &REG_L); }
-static void rr_hlp(CPU* cpu)
+static uint8_t rr_a(GB* gb) { rrn(gb, &REG_A); return 8; }
+static uint8_t rr_b(GB* gb) { rrn(gb, &REG_B); return 8; }
+static uint8_t rr_c(GB* gb) { rrn(gb, &REG_C); return 8; }
+static uint8_t rr_d(GB* gb) { rrn(gb, &REG_D); return 8; }
+static uint8_t rr_e(GB* gb) { rrn(gb, &REG_E); return 8; }
+static uint8_t rr_h(GB* gb) { rrn(gb, &REG_H); return 8; }
+static uint8_t rr_l(GB* gb) { rrn(gb, &REG_L); return 8; }
+static uint8_t rr_hlp(GB* gb)
 {
-    uint8_t value = read_byte(REG_HL);
-    rrn(cpu, &value);
-    write_byte(REG_HL, value);
+    uint8_t value = read_byte(gb, REG_HL);
+    rrn(gb, &value);
+    write_byte(gb, REG_HL, value);
+    return 16;
 }
 // Shifts
-static void sla_a(CPU* cpu) { sla(cpu, &REG_A); }
-static void sla_b(CPU* cpu) { sla(cpu, &REG_B); }
-static void sla_c(CPU* cpu) { sla(cpu, &REG_C); }
-static void sla_d(CPU* cpu) { sla(cpu, &REG_D); }
-static void sla_e(CPU* cpu) { sla(cpu, &REG_E); }
-static void sla_h(CPU* cpu) { sla(cpu, &REG_H); }
-static void sla_l(CPU* cpu) { sla(cpu, &REG_L); }
-static void sla_hlp(CPU* cpu) { uint8_t v = read_byte(REG_HL); sla(cpu, &v); write_byte(REG_HL, v); }
-static void sra_a(CPU* cpu) { sra(cpu, &REG_A); }
-static void sra_b(CPU* cpu) { sra(cpu, &REG_B); }
-static void sra_c(CPU* cpu) { sra(cpu, &REG_C); }
-static void sra_d(CPU* cpu) { sra(cpu, &REG_D); }
-static void sra_e(CPU* cpu) { sra(cpu, &REG_E); }
-static void sra_h(CPU* cpu) { sra(cpu, &REG_H); }
-static void sra_l(CPU* cpu) { sra(cpu, &REG_L); }
-static void sra_hlp(CPU* cpu) { uint8_t v = read_byte(REG_HL); sra(cpu, &v); write_byte(REG_HL, v); }
-static void srl_a(CPU* cpu) { srl(cpu, &REG_A); }
-static void srl_b(CPU* cpu) { srl(cpu, &REG_B); }
-static void srl_c(CPU* cpu) { srl(cpu, &REG_C); }
-static void srl_d(CPU* cpu) { srl(cpu, &REG_D); }
-static void srl_e(CPU* cpu) { srl(cpu, &REG_E); }
-static void srl_h(CPU* cpu) { srl(cpu, &REG_H); }
-static void srl_l(CPU* cpu) { srl(cpu, &REG_L); }
-static void srl_hlp(CPU* cpu) { uint8_t v = read_byte(REG_HL); srl(cpu, &v); write_byte(REG_HL, v); }
+static uint8_t sla_a(GB* gb) { sla(gb, &REG_A); return 8; }
+static uint8_t sla_b(GB* gb) { sla(gb, &REG_B); return 8; }
+static uint8_t sla_c(GB* gb) { sla(gb, &REG_C); return 8; }
+static uint8_t sla_d(GB* gb) { sla(gb, &REG_D); return 8; }
+static uint8_t sla_e(GB* gb) { sla(gb, &REG_E); return 8; }
+static uint8_t sla_h(GB* gb) { sla(gb, &REG_H); return 8; }
+static uint8_t sla_l(GB* gb) { sla(gb, &REG_L); return 8; }
+static uint8_t sla_hlp(GB* gb) { uint8_t v = read_byte(gb, REG_HL); sla(gb, &v); write_byte(gb, REG_HL, v); return 16; }
+static uint8_t sra_a(GB* gb) { sra(gb, &REG_A); return 8; }
+static uint8_t sra_b(GB* gb) { sra(gb, &REG_B); return 8; }
+static uint8_t sra_c(GB* gb) { sra(gb, &REG_C); return 8; }
+static uint8_t sra_d(GB* gb) { sra(gb, &REG_D); return 8; }
+static uint8_t sra_e(GB* gb) { sra(gb, &REG_E); return 8; }
+static uint8_t sra_h(GB* gb) { sra(gb, &REG_H); return 8; }
+static uint8_t sra_l(GB* gb) { sra(gb, &REG_L); return 8; }
+static uint8_t sra_hlp(GB* gb) { uint8_t v = read_byte(gb, REG_HL); sra(gb, &v); write_byte(gb, REG_HL, v); return 16; }
+static uint8_t srl_a(GB* gb) { srl(gb, &REG_A); return 8; }
+static uint8_t srl_b(GB* gb) { srl(gb, &REG_B); return 8; }
+static uint8_t srl_c(GB* gb) { srl(gb, &REG_C); return 8; }
+static uint8_t srl_d(GB* gb) { srl(gb, &REG_D); return 8; }
+static uint8_t srl_e(GB* gb) { srl(gb, &REG_E); return 8; }
+static uint8_t srl_h(GB* gb) { srl(gb, &REG_H); return 8; }
+static uint8_t srl_l(GB* gb) { srl(gb, &REG_L); return 8; }
+static uint8_t srl_hlp(GB* gb) { uint8_t v = read_byte(gb, REG_HL); srl(gb, &v); write_byte(gb, REG_HL, v); return 16; }
 // BIT
-static void bit0_b(CPU* cpu) { bit(0, &REG_B, cpu); }
-static void bit0_c(CPU* cpu) { bit(0, &REG_C, cpu); }
-static void bit0_d(CPU* cpu) { bit(0, &REG_D, cpu); }
-static void bit0_e(CPU* cpu) { bit(0, &REG_E, cpu); }
-static void bit0_h(CPU* cpu) { bit(0, &REG_H, cpu); }
-static void bit0_l(CPU* cpu) { bit(0, &REG_L, cpu); }
-static void bit0_hlp(CPU* cpu) 
+static uint8_t bit0_b(GB* gb) { bit(0, &REG_B, gb); return 8; }
+static uint8_t bit0_c(GB* gb) { bit(0, &REG_C, gb); return 8; }
+static uint8_t bit0_d(GB* gb) { bit(0, &REG_D, gb); return 8; }
+static uint8_t bit0_e(GB* gb) { bit(0, &REG_E, gb); return 8; }
+static uint8_t bit0_h(GB* gb) { bit(0, &REG_H, gb); return 8; }
+static uint8_t bit0_l(GB* gb) { bit(0, &REG_L, gb); return 8; }
+static uint8_t bit0_hlp(GB* gb) 
 {
-    uint8_t val = read_byte(REG_HL);
-    bit(0, &val, cpu);
+    uint8_t val = read_byte(gb, REG_HL);
+    bit(0, &val, gb);
+    return 12;
 }
-static void bit0_a(CPU* cpu) { bit(0, &REG_A, cpu); }
-
-static void bit1_b(CPU* cpu) { bit(1, &REG_B, cpu); }
-static void bit1_c(CPU* cpu) { bit(1, &REG_C, cpu); }
-static void bit1_d(CPU* cpu) { bit(1, &REG_D, cpu); }
-static void bit1_e(CPU* cpu) { bit(1, &REG_E, cpu); }
-static void bit1_h(CPU* cpu) { bit(1, &REG_H, cpu); }
-static void bit1_l(CPU* cpu) { bit(1, &REG_L, cpu); }
-static void bit1_hlp(CPU* cpu) 
+static uint8_t bit0_a(GB* gb) { bit(0, &REG_A, gb); return 8; }
+
+static uint8_t bit1_b(GB* gb) { bit(1, &REG_B, gb); return 8; }
+static uint8_t bit1_c(GB* gb) { bit(1, &REG_C, gb); return 8; }
+static uint8_t bit1_d(GB* gb) { bit(1, &REG_D, gb); return 8; }
+static uint8_t bit1_e(GB* gb) { bit(1, &REG_E, gb); return 8; }
+static uint8_t bit1_h(GB* gb) { bit(1, &REG_H, gb); return 8; }
+static uint8_t bit1_l(GB* gb) { bit(1, &REG_L, gb); return 8; }
+static uint8_t bit1_hlp(GB* gb) 
 {
-    uint8_t val = read_byte(REG_HL);
-    bit(1, &val, cpu);
+    uint8_t val = read_byte(gb, REG_HL);
+    bit(1, &val, gb);
+    return 12;
 }
-static void bit1_a(CPU* cpu) { bit(1, &REG_A, cpu); }
-
-static void bit2_b(CPU* cpu) { bit(2, &REG_B, cpu); }
-static void bit2_c(CPU* cpu) { bit(2, &REG_C, cpu); }
-static void bit2_d(CPU* cpu) { bit(2, &REG_D, cpu); }
-static void bit2_e(CPU* cpu) { bit(2, &REG_E, cpu); }
-static void bit2_h(CPU* cpu) { bit(2, &REG_H, cpu); }
-static void bit2_l(CPU* cpu) { bit(2, &REG_L, cpu); }
-static void bit2_hlp(CPU* cpu) 
+static uint8_t bit1_a(GB* gb) { bit(1, &REG_A, gb); return 8; }
+
+static uint8_t bit2_b(GB* gb) { bit(2, &REG_B, gb); return 8; }
+static uint8_t bit2_c(GB* gb) { bit(2, &REG_C, gb); return 8; }
+static uint8_t bit2_d(GB* gb) { bit(2, &REG_D, gb); return 8; }
+static uint8_t bit2_e(GB* gb) { bit(2, &REG_E, gb); return 8; }
+static uint8_t bit2_h(GB* gb) { bit(2, &REG_H, gb); return 8; }
+static uint8_t bit2_l(GB* gb) { bit(2, &REG_L, gb); return 8; }
+static uint8_t bit2_hlp(GB* gb) 
 {
-    uint8_t val = read_byte(REG_HL);
-    bit(2, &val, cpu);
+    uint8_t val = read_byte(gb, REG_HL);
+    bit(2, &val, gb);
+    return 12;
 }
-static void bit2_a(CPU* cpu) { bit(2, &REG_A, cpu); }
-
-static void bit3_b(CPU* cpu) { bit(3, &REG_B, cpu); }
-static void bit3_c(CPU* cpu) { bit(3, &REG_C, cpu); }
-static void bit3_d(CPU* cpu) { bit(3, &REG_D, cpu); }
-static void bit3_e(CPU* cpu) { bit(3, &REG_E, cpu); }
-static void bit3_h(CPU* cpu) { bit(3, &REG_H, cpu); }
-static void bit3_l(CPU* cpu) { bit(3, &REG_L, cpu); }
-static void bit3_hlp(CPU* cpu) 
+static uint8_t bit2_a(GB* gb) { bit(2, &REG_A, gb); return 8; }
+
+static uint8_t bit3_b(GB* gb) { bit(3, &REG_B, gb); return 8; }
+static uint8_t bit3_c(GB* gb) { bit(3, &REG_C, gb); return 8; }
+static uint8_t bit3_d(GB* gb) { bit(3, &REG_D, gb); return 8; }
+static uint8_t bit3_e(GB* gb) { bit(3, &REG_E, gb); return 8; }
+static uint8_t bit3_h(GB* gb) { bit(3, &REG_H, gb); return 8; }
+static uint8_t bit3_l(GB* gb) { bit(3, &REG_L, gb); return 8; }
+static uint8_t bit3_hlp(GB* gb) 
 {
-    uint8_t val = read_byte(REG_HL);
-    bit(3, &val, cpu);
+    uint8_t val = read_byte(gb, REG_HL);
+    bit(3, &val, gb);
+    return 12;
 }
-static void bit3_a(CPU* cpu) { bit(3, &REG_A, cpu); }
-
-static void bit4_b(CPU* cpu) { bit(4, &REG_B, cpu); }
-static void bit4_c(CPU* cpu) { bit(4, &REG_C, cpu); }
-static void bit4_d(CPU* cpu) { bit(4, &REG_D, cpu); }
-static void bit4_e(CPU* cpu) { bit(4, &REG_E, cpu); }
-static void bit4_h(CPU* cpu) { bit(4, &REG_H, cpu); }
-static void bit4_l(CPU* cpu) { bit(4, &REG_L, cpu); }
-static void bit4_hlp(CPU* cpu) 
+static uint8_t bit3_a(GB* gb) { bit(3, &REG_A, gb); return 8; }
+
+static uint8_t bit4_b(GB* gb) { bit(4, &REG_B, gb); return 8; }
+static uint8_t bit4_c(GB* gb) { bit(4, &REG_C, gb); return 8; }
+static uint8_t bit4_d(GB* gb) { bit(4, &REG_D, gb); return 8; }
+static uint8_t bit4_e(GB* gb) { bit(4, &REG_E, gb); return 8; }
+static uint8_t bit4_h(GB* gb) { bit(4, &REG_H, gb); return 8; }
+static uint8_t bit4_l(GB* gb) { bit(4, &REG_L, gb); return 8; }
+static uint8_t bit4_hlp(GB* gb) 
 {
-    uint8_t val = read_byte(REG_HL);
-    bit(4, &val, cpu);
+    uint8_t val = read_byte(gb, REG_HL);
+    bit(4, &val, gb);
+    return 12;
 }
-static void bit4_a(CPU* cpu) { bit(4, &REG_A, cpu); }
-
-static void bit5_b(CPU* cpu) { bit(5, &REG_B, cpu); }
-static void bit5_c(CPU* cpu) { bit(5, &REG_C, cpu); }
-static void bit5_d(CPU* cpu) { bit(5, &REG_D, cpu); }
-static void bit5_e(CPU* cpu) { bit(5, &REG_E, cpu); }
-static void bit5_h(CPU* cpu) { bit(5, &REG_H, cpu); }
-static void bit5_l(CPU* cpu) { bit(5, &REG_L, cpu); }
-static void bit5_hlp(CPU* cpu) 
+static uint8_t bit4_a(GB* gb) { bit(4, &REG_A, gb); return 8; }
+
+static uint8_t bit5_b(GB* gb) { bit(5, &REG_B, gb); return 8; }
+static uint8_t bit5_c(GB* gb) { bit(5, &REG_C, gb); return 8; }
+static uint8_t bit5_d(GB* gb) { bit(5, &REG_D, gb); return 8; }
+static uint8_t bit5_e(GB* gb) { bit(5, &REG_E, gb); return 8; }
+static uint8_t bit5_h(GB* gb) { bit(5, &REG_H, gb); return 8; }
+static uint8_t bit5_l(GB* gb) { bit(5, &REG_L, gb); return 8; }
+static uint8_t bit5_hlp(GB* gb) 
 {
-    uint8_t val = read_byte(REG_HL);
-    bit(5, &val, cpu);
+    uint8_t val = read_byte(gb, REG_HL);
+    bit(5, &val, gb);
+    return 12;
 }
-static void bit5_a(CPU* cpu) { bit(5, &REG_A, cpu); }
-
-static void bit6_b(CPU* cpu) { bit(6, &REG_B, cpu); }
-static void bit6_c(CPU* cpu) { bit(6, &REG_C, cpu); }
-static void bit6_d(CPU* cpu) { bit(6, &REG_D, cpu); }
-static void bit6_e(CPU* cpu) { bit(6, &REG_E, cpu); }
-static void bit6_h(CPU* cpu) { bit(6, &REG_H, cpu); }
-static void bit6_l(CPU* cpu) { bit(6, &REG_L, cpu); }
-static void bit6_hlp(CPU* cpu) 
+static uint8_t bit5_a(GB* gb) { bit(5, &REG_A, gb); return 8; }
+
+static uint8_t bit6_b(GB* gb) { bit(6, &REG_B, gb); return 8; }
+static uint8_t bit6_c(GB* gb) { bit(6, &REG_C, gb); return 8; }
+static uint8_t bit6_d(GB* gb) { bit(6, &REG_D, gb); return 8; }
+static uint8_t bit6_e(GB* gb) { bit(6, &REG_E, gb); return 8; }
+static uint8_t bit6_h(GB* gb) { bit(6, &REG_H, gb); return 8; }
+static uint8_t bit6_l(GB* gb) { bit(6, &REG_L, gb); return 8; }
+static uint8_t bit6_hlp(GB* gb) 
 {
-    uint8_t val = read_byte(REG_HL);
-    bit(6, &val, cpu);
+    uint8_t val = read_byte(gb, REG_HL);
+    bit(6, &val, gb);
+    return 12;
 }
-static void bit6_a(CPU* cpu) { bit(6, &REG_A, cpu); }
-
-static void bit7_b(CPU* cpu) { bit(7, &REG_B, cpu); }
-static void bit7_c(CPU* cpu) { bit(7, &REG_C, cpu); }
-static void bit7_d(CPU* cpu) { bit(7, &REG_D, cpu); }
-static void bit7_e(CPU* cpu) { bit(7, &REG_E, cpu); }
-static void bit7_h(CPU* cpu) { bit(7, &REG_H, cpu); }
-static void bit7_l(CPU* cpu) { bit(7, &REG_L, cpu); }
-static void bit7_hlp(CPU* cpu) 
+static uint8_t bit6_a(GB* gb) { bit(6, &REG_A, gb); return 8; }
+
+static uint8_t bit7_b(GB* gb) { bit(7, &REG_B, gb); return 8; }
+static uint8_t bit7_c(GB* gb) { bit(7, &REG_C, gb); return 8; }
+static uint8_t bit7_d(GB* gb) { bit(7, &REG_D, gb); return 8; }
+static uint8_t bit7_e(GB* gb) { bit(7, &REG_E, gb); return 8; }
+static uint8_t bit7_h(GB* gb) { bit(7, &REG_H, gb); return 8; }
+static uint8_t bit7_l(GB* gb) { bit(7, &REG_L, gb); return 8; }
+static uint8_t bit7_hlp(GB* gb) 
 {
-    uint8_t val = read_byte(REG_HL);
-    bit(7, &val, cpu);
+    uint8_t val = read_byte(gb, REG_HL);
+    bit(7, &val, gb);
+    return 12;
 }
-static void bit7_a(CPU* cpu) { bit(7, &REG_A, cpu); }
+static uint8_t bit7_a(GB* gb) { bit(7, &REG_A, gb); return 8; }
 // RES
-static void res0_b(CPU* cpu) { res(0, &REG_B); }
-static void res0_c(CPU* cpu) { res(0, &REG_C); }
-static void res0_d(CPU* cpu) { res(0, &REG_D); }
-static void res0_e(CPU* cpu) { res(0, &REG_E); }
-static void res0_h(CPU* cpu) { res(0, &REG_H); }
-static void res0_l(CPU* cpu) { res(0, &REG_L); }
-static void res0_hlp(CPU* cpu) 
+static uint8_t res0_b(GB* gb) { res(0, &REG_B); return 8; }
+static uint8_t res0_c(GB* gb) { res(0, &REG_C); return 8; }
+static uint8_t res0_d(GB* gb) { res(0, &REG_D); return 8; }
+static uint8_t res0_e(GB* gb) { res(0, &REG_E); return 8; }
+static uint8_t res0_h(GB* gb) { res(0, &REG_H); return 8; }
+static uint8_t res0_l(GB* gb) { res(0, &REG_L); return 8; }
+static uint8_t res0_hlp(GB* gb) 
 {
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);
+    uint8_t val = read_byte(gb, addr);
     res(0, &val);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
-static void res0_a(CPU* cpu) { res(0, &REG_A); }
-
-static void res1_a(CPU* cpu) { REG_A &= ~(1 << 1); }
-static void res1_b(CPU* cpu) { REG_B &= ~(1 << 1); }
-static void res1_c(CPU* cpu) { REG_C &= ~(1 << 1); }
-static void res1_d(CPU* cpu) { REG_D &= ~(1 << 1); }
-static void res1_e(CPU* cpu) { REG_E &= ~(1 << 1); }
-static void res1_h(CPU* cpu) { REG_H &= ~(1 << 1); }
-static void res1_l(CPU* cpu) { REG_L &= ~(1 << 1); }
-static void res1_hlp(CPU* cpu) 
+static uint8_t res0_a(GB* gb) { res(0, &REG_A); return 8; }
+
+static uint8_t res1_a(GB* gb) { REG_A &= ~(1 << 1); return 8; }
+static uint8_t res1_b(GB* gb) { REG_B &= ~(1 << 1); return 8; }
+static uint8_t res1_c(GB* gb) { REG_C &= ~(1 << 1); return 8; }
+static uint8_t res1_d(GB* gb) { REG_D &= ~(1 << 1); return 8; }
+static uint8_t res1_e(GB* gb) { REG_E &= ~(1 << 1); return 8; }
+static uint8_t res1_h(GB* gb) { REG_H &= ~(1 << 1); return 8; }
+static uint8_t res1_l(GB* gb) { REG_L &= ~(1 << 1); return 8; }
+static uint8_t res1_hlp(GB* gb) 
 {
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);       
+    uint8_t val = read_byte(gb, addr);       
     val &= ~(1 << 1);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
 
-static void res2_a(CPU* cpu) { REG_A &= ~(1 << 2); }
-static void res2_b(CPU* cpu) { REG_B &= ~(1 << 2); }
-static void res2_c(CPU* cpu) { REG_C &= ~(1 << 2); }
-static void res2_d(CPU* cpu) { REG_D &= ~(1 << 2); }
-static void res2_e(CPU* cpu) { REG_E &= ~(1 << 2); }
-static void res2_h(CPU* cpu) { REG_H &= ~(1 << 2); }
-static void res2_l(CPU* cpu) { REG_L &= ~(1 << 2); }
-static void res2_hlp(CPU* cpu) 
+static uint8_t res2_a(GB* gb) { REG_A &= ~(1 << 2); return 8; }
+static uint8_t res2_b(GB* gb) { REG_B &= ~(1 << 2); return 8; }
+static uint8_t res2_c(GB* gb) { REG_C &= ~(1 << 2); return 8; }
+static uint8_t res2_d(GB* gb) { REG_D &= ~(1 << 2); return 8; }
+static uint8_t res2_e(GB* gb) { REG_E &= ~(1 << 2); return 8; }
+static uint8_t res2_h(GB* gb) { REG_H &= ~(1 << 2); return 8; }
+static uint8_t res2_l(GB* gb) { REG_L &= ~(1 << 2); return 8; }
+static uint8_t res2_hlp(GB* gb) 
 {
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);       
+    uint8_t val = read_byte(gb, addr);       
     val &= ~(1 << 2);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
 
-static void res3_a(CPU* cpu) { REG_A &= ~(1 << 3); }
-static void res3_b(CPU* cpu) { REG_B &= ~(1 << 3); }
-static void res3_c(CPU* cpu) { REG_C &= ~(1 << 3); }
-static void res3_d(CPU* cpu) { REG_D &= ~(1 << 3); }
-static void res3_e(CPU* cpu) { REG_E &= ~(1 << 3); }
-static void res3_h(CPU* cpu) { REG_H &= ~(1 << 3); }
-static void res3_l(CPU* cpu) { REG_L &= ~(1 << 3); }
-static void res3_hlp(CPU* cpu) 
+static uint8_t res3_a(GB* gb) { REG_A &= ~(1 << 3); return 8; }
+static uint8_t res3_b(GB* gb) { REG_B &= ~(1 << 3); return 8; }
+static uint8_t res3_c(GB* gb) { REG_C &= ~(1 << 3); return 8; }
+static uint8_t res3_d(GB* gb) { REG_D &= ~(1 << 3); return 8; }
+static uint8_t res3_e(GB* gb) { REG_E &= ~(1 << 3); return 8; }
+static uint8_t res3_h(GB* gb) { REG_H &= ~(1 << 3); return 8; }
+static uint8_t res3_l(GB* gb) { REG_L &= ~(1 << 3); return 8; }
+static uint8_t res3_hlp(GB* gb) 
 {
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);       
+    uint8_t val = read_byte(gb, addr);       
     val &= ~(1 << 3);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
 
-static void res4_a(CPU* cpu) { REG_A &= ~(1 << 4); }
-static void res4_b(CPU* cpu) { REG_B &= ~(1 << 4); }
-static void res4_c(CPU* cpu) { REG_C &= ~(1 << 4); }
-static void res4_d(CPU* cpu) { REG_D &= ~(1 << 4); }
-static void res4_e(CPU* cpu) { REG_E &= ~(1 << 4); }
-static void res4_h(CPU* cpu) { REG_H &= ~(1 << 4); }
-static void res4_l(CPU* cpu) { REG_L &= ~(1 << 4); }
-static void res4_hlp(CPU* cpu) 
+static uint8_t res4_a(GB* gb) { REG_A &= ~(1 << 4); return 8; }
+static uint8_t res4_b(GB* gb) { REG_B &= ~(1 << 4); return 8; }
+static uint8_t res4_c(GB* gb) { REG_C &= ~(1 << 4); return 8; }
+static uint8_t res4_d(GB* gb) { REG_D &= ~(1 << 4); return 8; }
+static uint8_t res4_e(GB* gb) { REG_E &= ~(1 << 4); return 8; }
+static uint8_t res4_h(GB* gb) { REG_H &= ~(1 << 4); return 8; }
+static uint8_t res4_l(GB* gb) { REG_L &= ~(1 << 4); return 8; }
+static uint8_t res4_hlp(GB* gb) 
 {
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);       
+    uint8_t val = read_byte(gb, addr);       
     val &= ~(1 << 4);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
 
-static void res5_a(CPU* cpu) { REG_A &= ~(1 << 5); }
-static void res5_b(CPU* cpu) { REG_B &= ~(1 << 5); }
-static void res5_c(CPU* cpu) { REG_C &= ~(1 << 5); }
-static void res5_d(CPU* cpu) { REG_D &= ~(1 << 5); }
-static void res5_e(CPU* cpu) { REG_E &= ~(1 << 5); }
-static void res5_h(CPU* cpu) { REG_H &= ~(1 << 5); }
-static void res5_l(CPU* cpu) { REG_L &= ~(1 << 5); }
-static void res5_hlp(CPU* cpu)
+static uint8_t res5_a(GB* gb) { REG_A &= ~(1 << 5); return 8; }
+static uint8_t res5_b(GB* gb) { REG_B &= ~(1 << 5); return 8; }
+static uint8_t res5_c(GB* gb) { REG_C &= ~(1 << 5); return 8; }
+static uint8_t res5_d(GB* gb) { REG_D &= ~(1 << 5); return 8; }
+static uint8_t res5_e(GB* gb) { REG_E &= ~(1 << 5); return 8; }
+static uint8_t res5_h(GB* gb) { REG_H &= ~(1 << 5); return 8; }
+static uint8_t res5_l(GB* gb) { REG_L &= ~(1 << 5); return 8; }
+static uint8_t res5_hlp(GB* gb)
 {
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);       
+    uint8_t val = read_byte(gb, addr);       
     val &= ~(1 << 5);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
 
-static void res6_a(CPU* cpu) { REG_A &= ~(1 << 6); }
-static void res6_b(CPU* cpu) { REG_B &= ~(1 << 6); }
-static void res6_c(CPU* cpu) { REG_C &= ~(1 << 6); }
-static void res6_d(CPU* cpu) { REG_D &= ~(1 << 6); }
-static void res6_e(CPU* cpu) { REG_E &= ~(1 << 6); }
-static void res6_h(CPU* cpu) { REG_H &= ~(1 << 6); }
-static void res6_l(CPU* cpu) { REG_L &= ~(1 << 6); }
-static void res6_hlp(CPU* cpu)
+static uint8_t res6_a(GB* gb) { REG_A &= ~(1 << 6); return 8; }
+static uint8_t res6_b(GB* gb) { REG_B &= ~(1 << 6); return 8; }
+static uint8_t res6_c(GB* gb) { REG_C &= ~(1 << 6); return 8; }
+static uint8_t res6_d(GB* gb) { REG_D &= ~(1 << 6); return 8; }
+static uint8_t res6_e(GB* gb) { REG_E &= ~(1 << 6); return 8; }
+static uint8_t res6_h(GB* gb) { REG_H &= ~(1 << 6); return 8; }
+static uint8_t res6_l(GB* gb) { REG_L &= ~(1 << 6); return 8; }
+static uint8_t res6_hlp(GB* gb)
 {
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);       
+    uint8_t val = read_byte(gb, addr);       
     val &= ~(1 << 6);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
 
-static void res7_a(CPU* cpu) { REG_A &= ~(1 << 7); }
-static void res7_b(CPU* cpu) { REG_B &= ~(1 << 7); }
-static void res7_c(CPU* cpu) { REG_C &= ~(1 << 7); }
-static void res7_d(CPU* cpu) { REG_D &= ~(1 << 7); }
-static void res7_e(CPU* cpu) { REG_E &= ~(1 << 7); }
-static void res7_h(CPU* cpu) { REG_H &= ~(1 << 7); }
-static void res7_l(CPU* cpu) { REG_L &= ~(1 << 7); }
-static void res7_hlp(CPU* cpu) 
+static uint8_t res7_a(GB* gb) { REG_A &= ~(1 << 7); return 8; }
+static uint8_t res7_b(GB* gb) { REG_B &= ~(1 << 7); return 8; }
+static uint8_t res7_c(GB* gb) { REG_C &= ~(1 << 7); return 8; }
+static uint8_t res7_d(GB* gb) { REG_D &= ~(1 << 7); return 8; }
+static uint8_t res7_e(GB* gb) { REG_E &= ~(1 << 7); return 8; }
+static uint8_t res7_h(GB* gb) { REG_H &= ~(1 << 7); return 8; }
+static uint8_t res7_l(GB* gb) { REG_L &= ~(1 << 7); return 8; }
+static uint8_t res7_hlp(GB* gb) 
 {
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);       
+    uint8_t val = read_byte(gb, addr);       
     val &= ~(1 << 7);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
 // SET
-static void set0_b(CPU* cpu) { set(0, &REG_B); }
-static void set0_c(CPU* cpu) { set(0, &REG_C); }
-static void set0_d(CPU* cpu) { set(0, &REG_D); }
-static void set0_e(CPU* cpu) { set(0, &REG_E); }
-static void set0_h(CPU* cpu) { set(0, &REG_H); }
-static void set0_l(CPU* cpu) { set(0, &REG_L); }
-static void set0_hlp(CPU* cpu)
+static uint8_t set0_b(GB* gb) { set(0, &REG_B); return 8; }
+static uint8_t set0_c(GB* gb) { set(0, &REG_C); return 8; }
+static uint8_t set0_d(GB* gb) { set(0, &REG_D); return 8; }
+static uint8_t set0_e(GB* gb) { set(0, &REG_E); return 8; }
+static uint8_t set0_h(GB* gb) { set(0, &REG_H); return 8; }
+static uint8_t set0_l(GB* gb) { set(0, &REG_L); return 8; }
+static uint8_t set0_hlp(GB* gb)
 {
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);
+    uint8_t val = read_byte(gb, addr);
     set(0, &val);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
-static void set0_a(CPU* cpu) { set(0, &REG_A); }
-
-static void set1_a(CPU* cpu) { REG_A |= (1 << 1); }
-static void set1_b(CPU* cpu) { REG_B |= (1 << 1); }
-static void set1_c(CPU* cpu) { REG_C |= (1 << 1); }
-static void set1_d(CPU* cpu) { REG_D |= (1 << 1); }
-static void set1_e(CPU* cpu) { REG_E |= (1 << 1); }
-static void set1_h(CPU* cpu) { REG_H |= (1 << 1); }
-static void set1_l(CPU* cpu) { REG_L |= (1 << 1); }
-static void set1_hlp(CPU* cpu) 
+static uint8_t set0_a(GB* gb) { set(0, &REG_A); return 8; }
+
+static uint8_t set1_a(GB* gb) { REG_A |= (1 << 1); return 8; }
+static uint8_t set1_b(GB* gb) { REG_B |= (1 << 1); return 8; }
+static uint8_t set1_c(GB* gb) { REG_C |= (1 << 1); return 8; }
+static uint8_t set1_d(GB* gb) { REG_D |= (1 << 1); return 8; }
+static uint8_t set1_e(GB* gb) { REG_E |= (1 << 1); return 8; }
+static uint8_t set1_h(GB* gb) { REG_H |= (1 << 1); return 8; }
+static uint8_t set1_l(GB* gb) { REG_L |= (1 << 1); return 8; }
+static uint8_t set1_hlp(GB* gb) 
 { 
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);       
+    uint8_t val = read_byte(gb, addr);       
     val |= (1 << 1);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
 
-static void set2_a(CPU* cpu) { REG_A |= (1 << 2); }
-static void set2_b(CPU* cpu) { REG_B |= (1 << 2); }
-static void set2_c(CPU* cpu) { REG_C |= (1 << 2); }
-static void set2_d(CPU* cpu) { REG_D |= (1 << 2); }
-static void set2_e(CPU* cpu) { REG_E |= (1 << 2); }
-static void set2_h(CPU* cpu) { REG_H |= (1 << 2); }
-static void set2_l(CPU* cpu) { REG_L |= (1 << 2); }
-static void set2_hlp(CPU* cpu) 
+static uint8_t set2_a(GB* gb) { REG_A |= (1 << 2); return 8; }
+static uint8_t set2_b(GB* gb) { REG_B |= (1 << 2); return 8; }
+static uint8_t set2_c(GB* gb) { REG_C |= (1 << 2); return 8; }
+static uint8_t set2_d(GB* gb) { REG_D |= (1 << 2); return 8; }
+static uint8_t set2_e(GB* gb) { REG_E |= (1 << 2); return 8; }
+static uint8_t set2_h(GB* gb) { REG_H |= (1 << 2); return 8; }
+static uint8_t set2_l(GB* gb) { REG_L |= (1 << 2); return 8; }
+static uint8_t set2_hlp(GB* gb) 
 {
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);       
+    uint8_t val = read_byte(gb, addr);       
     val |= (1 << 2);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
 
-static void set3_a(CPU* cpu) { REG_A |= (1 << 3); }
-static void set3_b(CPU* cpu) { REG_B |= (1 << 3); }
-static void set3_c(CPU* cpu) { REG_C |= (1 << 3); }
-static void set3_d(CPU* cpu) { REG_D |= (1 << 3); }
-static void set3_e(CPU* cpu) { REG_E |= (1 << 3); }
-static void set3_h(CPU* cpu) { REG_H |= (1 << 3); }
-static void set3_l(CPU* cpu) { REG_L |= (1 << 3); }
-static void set3_hlp(CPU* cpu) 
+static uint8_t set3_a(GB* gb) { REG_A |= (1 << 3); return 8; }
+static uint8_t set3_b(GB* gb) { REG_B |= (1 << 3); return 8; }
+static uint8_t set3_c(GB* gb) { REG_C |= (1 << 3); return 8; }
+static uint8_t set3_d(GB* gb) { REG_D |= (1 << 3); return 8; }
+static uint8_t set3_e(GB* gb) { REG_E |= (1 << 3); return 8; }
+static uint8_t set3_h(GB* gb) { REG_H |= (1 << 3); return 8; }
+static uint8_t set3_l(GB* gb) { REG_L |= (1 << 3); return 8; }
+static uint8_t set3_hlp(GB* gb) 
 {
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);       
+    uint8_t val = read_byte(gb, addr);       
     val |= (1 << 3);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
 
-static void set4_a(CPU* cpu) { REG_A |= (1 << 4); }
-static void set4_b(CPU* cpu) { REG_B |= (1 << 4); }
-static void set4_c(CPU* cpu) { REG_C |= (1 << 4); }
-static void set4_d(CPU* cpu) { REG_D |= (1 << 4); }
-static void set4_e(CPU* cpu) { REG_E |= (1 << 4); }
-static void set4_h(CPU* cpu) { REG_H |= (1 << 4); }
-static void set4_l(CPU* cpu) { REG_L |= (1 << 4); }
-static void set4_hlp(CPU* cpu) 
+static uint8_t set4_a(GB* gb) { REG_A |= (1 << 4); return 8; }
+static uint8_t set4_b(GB* gb) { REG_B |= (1 << 4); return 8; }
+static uint8_t set4_c(GB* gb) { REG_C |= (1 << 4); return 8; }
+static uint8_t set4_d(GB* gb) { REG_D |= (1 << 4); return 8; }
+static uint8_t set4_e(GB* gb) { REG_E |= (1 << 4); return 8; }
+static uint8_t set4_h(GB* gb) { REG_H |= (1 << 4); return 8; }
+static uint8_t set4_l(GB* gb) { REG_L |= (1 << 4); return 8; }
+static uint8_t set4_hlp(GB* gb) 
 {
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);       
+    uint8_t val = read_byte(gb, addr);       
     val |= (1 << 4);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
 
-static void set5_a(CPU* cpu) { REG_A |= (1 << 5); }
-static void set5_b(CPU* cpu) { REG_B |= (1 << 5); }
-static void set5_c(CPU* cpu) { REG_C |= (1 << 5); }
-static void set5_d(CPU* cpu) { REG_D |= (1 << 5); }
-static void set5_e(CPU* cpu) { REG_E |= (1 << 5); }
-static void set5_h(CPU* cpu) { REG_H |= (1 << 5); }
-static void set5_l(CPU* cpu) { REG_L |= (1 << 5); }
-static void set5_hlp(CPU* cpu) 
+static uint8_t set5_a(GB* gb) { REG_A |= (1 << 5); return 8; }
+static uint8_t set5_b(GB* gb) { REG_B |= (1 << 5); return 8; }
+static uint8_t set5_c(GB* gb) { REG_C |= (1 << 5); return 8; }
+static uint8_t set5_d(GB* gb) { REG_D |= (1 << 5); return 8; }
+static uint8_t set5_e(GB* gb) { REG_E |= (1 << 5); return 8; }
+static uint8_t set5_h(GB* gb) { REG_H |= (1 << 5); return 8; }
+static uint8_t set5_l(GB* gb) { REG_L |= (1 << 5); return 8; }
+static uint8_t set5_hlp(GB* gb) 
 {
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);       
+    uint8_t val = read_byte(gb, addr);       
     val |= (1 << 5);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
 
-static void set6_a(CPU* cpu) { REG_A |= (1 << 6); }
-static void set6_b(CPU* cpu) { REG_B |= (1 << 6); }
-static void set6_c(CPU* cpu) { REG_C |= (1 << 6); }
-static void set6_d(CPU* cpu) { REG_D |= (1 << 6); }
-static void set6_e(CPU* cpu) { REG_E |= (1 << 6); }
-static void set6_h(CPU* cpu) { REG_H |= (1 << 6); }
-static void set6_l(CPU* cpu) { REG_L |= (1 << 6); }
-static void set6_hlp(CPU* cpu) 
+static uint8_t set6_a(GB* gb) { REG_A |= (1 << 6); return 8; }
+static uint8_t set6_b(GB* gb) { REG_B |= (1 << 6); return 8; }
+static uint8_t set6_c(GB* gb) { REG_C |= (1 << 6); return 8; }
+static uint8_t set6_d(GB* gb) { REG_D |= (1 << 6); return 8; }
+static uint8_t set6_e(GB* gb) { REG_E |= (1 << 6); return 8; }
+static uint8_t set6_h(GB* gb) { REG_H |= (1 << 6); return 8; }
+static uint8_t set6_l(GB* gb) { REG_L |= (1 << 6); return 8; }
+static uint8_t set6_hlp(GB* gb) 
 {   
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);       
+    uint8_t val = read_byte(gb, addr);       
     val |= (1 << 6);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
 
-static void set7_a(CPU* cpu) { REG_A |= (1 << 7); }
-static void set7_b(CPU* cpu) { REG_B |= (1 << 7); }
-static void set7_c(CPU* cpu) { REG_C |= (1 << 7); }
-static void set7_d(CPU* cpu) { REG_D |= (1 << 7); }
-static void set7_e(CPU* cpu) { REG_E |= (1 << 7); }
-static void set7_h(CPU* cpu) { REG_H |= (1 << 7); }
-static void set7_l(CPU* cpu) { REG_L |= (1 << 7); }
-static void set7_hlp(CPU* cpu) 
+static uint8_t set7_a(GB* gb) { REG_A |= (1 << 7); return 8; }
+static uint8_t set7_b(GB* gb) { REG_B |= (1 << 7); return 8; }
+static uint8_t set7_c(GB* gb) { REG_C |= (1 << 7); return 8; }
+static uint8_t set7_d(GB* gb) { REG_D |= (1 << 7); return 8; }
+static uint8_t set7_e(GB* gb) { REG_E |= (1 << 7); return 8; }
+static uint8_t set7_h(GB* gb) { REG_H |= (1 << 7); return 8; }
+static uint8_t set7_l(GB* gb) { REG_L |= (1 << 7); return 8; }
+static uint8_t set7_hlp(GB* gb) 
 { 
     uint16_t addr = REG_HL;
-    uint8_t val = read_byte(addr);       
+    uint8_t val = read_byte(gb, addr);       
     val |= (1 << 7);
-    write_byte(addr, val);
+    write_byte(gb, addr, val);
+    return 16;
 }
 // JP
-static void jp_nn_op(CPU* cpu) { jp_nn(cpu); }
-static void jp_nz_nn(CPU* cpu) { jp_cc_nn(cpu, NZ); }
-static void jp_z_nn(CPU* cpu)  { jp_cc_nn(cpu, Z); }
-static void jp_nc_nn(CPU* cpu) { jp_cc_nn(cpu, NC); }
-static void jp_c_nn(CPU* cpu)  { jp_cc_nn(cpu, C); }
-static void jp_hl_op(CPU* cpu) { REG_PC = REG_HL; }
-static void jr_n_op(CPU* cpu) { jr_n(cpu); }
-static void jr_nz_op(CPU* cpu) { jr_cc_n(cpu, NZ); }
-static void jr_z_op(CPU* cpu)  { jr_cc_n(cpu, Z); }
-static void jr_nc_op(CPU* cpu) { jr_cc_n(cpu, NC); }
-static void jr_c_op(CPU* cpu)  { jr_cc_n(cpu, C); }
+static uint8_t jp_nn_op(GB* gb) { jp_nn(gb); return 16; }
+static uint8_t jp_nz_nn(GB* gb) { return jp_cc_nn(gb, NZ); }
+static uint8_t jp_z_nn(GB* gb)  { return jp_cc_nn(gb, Z); }
+static uint8_t jp_nc_nn(GB* gb) { return jp_cc_nn(gb, NC); }
+static uint8_t jp_c_nn(GB* gb)  { return jp_cc_nn(gb, C); }
+static uint8_t jp_hl_op(GB* gb) { REG_PC = REG_HL; return 4; }
+static uint8_t jr_n_op(GB* gb) { jr_n(gb); return 12; }
+static uint8_t jr_nz_op(GB* gb) { return jr_cc_n(gb, NZ); }
+static uint8_t jr_z_op(GB* gb)  { return jr_cc_n(gb, Z); }
+static uint8_t jr_nc_op(GB* gb) { return jr_cc_n(gb, NC); }
+static uint8_t jr_c_op(GB* gb)  { return jr_cc_n(gb, C); }
 // CALL
-static void call_nn_op(CPU* cpu) { call_nn(cpu); }
-static void call_nz_op(CPU* cpu) { call_cc_nn(cpu, NZ); }
-static void call_z_op(CPU* cpu)  { call_cc_nn(cpu, Z); }
-static void call_nc_op(CPU* cpu) { call_cc_nn(cpu, NC); }
-static void call_c_op(CPU* cpu)  { call_cc_nn(cpu, C); }
+static uint8_t call_nn_op(GB* gb) { call_nn(gb); return 24; }
+static uint8_t call_nz_op(GB* gb) { return call_cc_nn(gb, NZ); }
+static uint8_t call_z_op(GB* gb)  { return call_cc_nn(gb, Z); }
+static uint8_t call_nc_op(GB* gb) { return call_cc_nn(gb, NC); }
+static uint8_t call_c_op(GB* gb)  { return call_cc_nn(gb, C); }
 // RST
-static void rst_00(CPU* cpu) { rst_n(cpu, 0x00); }
-static void rst_08(CPU* cpu) { rst_n(cpu, 0x08); }
-static void rst_10(CPU* cpu) { rst_n(cpu, 0x10); }
-static void rst_18(CPU* cpu) { rst_n(cpu, 0x18); }
-static void rst_20(CPU* cpu) { rst_n(cpu, 0x20); }
-static void rst_28(CPU* cpu) { rst_n(cpu, 0x28); }
-static void rst_30(CPU* cpu) { rst_n(cpu, 0x30); }
-static void rst_38(CPU* cpu) { rst_n(cpu, 0x38); }
+static uint8_t rst_00(GB* gb) { rst_n(gb, 0x00); return 16; }
+static uint8_t rst_08(GB* gb) { rst_n(gb, 0x08); return 16; }
+static uint8_t rst_10(GB* gb) { rst_n(gb, 0x10); return 16; }
+static uint8_t rst_18(GB* gb) { rst_n(gb, 0x18); return 16; }
+static uint8_t rst_20(GB* gb) { rst_n(gb, 0x20); return 16; }
+static uint8_t rst_28(GB* gb) { rst_n(gb, 0x28); return 16; }
+static uint8_t rst_30(GB* gb) { rst_n(gb, 0x30); return 16; }
+static uint8_t rst_38(GB* gb) { rst_n(gb, 0x38); return 16; }
 // RET
-static void ret_op(CPU* cpu) { ret(cpu); }
-static void ret_nz(CPU* cpu) { ret_cc(cpu, NZ); }
-static void ret_z(CPU* cpu)  { ret_cc(cpu, Z); }
-static void ret_nc(CPU* cpu) { ret_cc(cpu, NC); }
-static void ret_c(CPU* cpu)  { ret_cc(cpu, C); }
-static void reti_op(CPU* cpu) { reti(cpu); }
-
-static void add_a_imm(CPU* cpu) {
-    uint8_t value = read_byte(REG_PC++);
-    add_a_n(cpu, value);
+static uint8_t ret_op(GB* gb) { ret(gb); return 16; }
+static uint8_t ret_nz(GB* gb) { return ret_cc(gb, NZ); }
+static uint8_t ret_z(GB* gb)  { return ret_cc(gb, Z); }
+static uint8_t ret_nc(GB* gb) { return ret_cc(gb, NC); }
+static uint8_t ret_c(GB* gb)  { return ret_cc(gb, C); }
+static uint8_t reti_op(GB* gb) { reti(gb); return 16; }
+
+static uint8_t add_a_imm(GB* gb) {
+    uint8_t value = read_byte(gb, REG_PC++);
+    add_a_n(gb, value);
+    return 8;
 }
-static void adc_a_imm(CPU* cpu) {
-    uint8_t value = read_byte(REG_PC++);
-    adc_a_n(cpu, value);
+static uint8_t adc_a_imm(GB* gb) {
+    uint8_t value = read_byte(gb, REG_PC++);
+    adc_a_n(gb, value);
+    return 8;
 }
-static void sub_a_imm(CPU* cpu) {
-    uint8_t value = read_byte(REG_PC++);
-    sub_a_n(cpu, value);
+static uint8_t sub_a_imm(GB* gb) {
+    uint8_t value = read_byte(gb, REG_PC++);
+    sub_a_n(gb, value);
+    return 8;
 }
-static void sbc_a_imm(CPU* cpu) {
-    uint8_t value = read_byte(REG_PC++);
-    sbc_a_n(cpu, value);
+static uint8_t sbc_a_imm(GB* gb) {
+    uint8_t value = read_byte(gb, REG_PC++);
+    sbc_a_n(gb, value);
+    return 8;
 }
-static void and_a_imm(CPU* cpu) {
-    uint8_t value = read_byte(REG_PC++);
-    and_a_n(cpu, value);
+static uint8_t and_a_imm(GB* gb) {
+    uint8_t value = read_byte(gb, REG_PC++);
+    and_a_n(gb, value);
+    return 8;
 }
-static void xor_a_imm(CPU* cpu) {
-    uint8_t value = read_byte(REG_PC++);
-    xor_a_n(cpu, value);
+static uint8_t xor_a_imm(GB* gb) {
+    uint8_t value = read_byte(gb, REG_PC++);
+    xor_a_n(gb, value);
+    return 8;
 }
-static void or_a_imm(CPU* cpu) {
-    uint8_t value = read_byte(REG_PC++);
-    or_a_n(cpu, value);
+static uint8_t or_a_imm(GB* gb) {
+    uint8_t value = read_byte(gb, REG_PC++);
+    or_a_n(gb, value);
+    return 8;
 }
 
 Opcode opcodes[256];
 Opcode cb_opcodes[256];
 
+// Handlers return the cycles they took; these tables hold the same counts
+// (not-taken for conditional branches) for code that needs them up front.
 const uint8_t opcode_cycles[256] = {
     4, 12, 8, 8, 4, 4, 8, 4, 20, 8, 8, 8, 4, 4, 8, 4,
     4, 12, 8, 8, 4, 4, 8, 4, 12, 8, 8, 8, 4, 4, 8, 4,
@@ -808,6 +864,7 @@ void init_opcodes()
 
     // MISC
     opcodes[0x00] = nop;
+    opcodes[0xCB] = prefix_cb;
     opcodes[0x76] = halt;
     opcodes[0x10] = stop;
     opcodes[0xF3] = di;
@@ -830,6 +887,8 @@ void init_opcodes()
     opcodes[0x32] = ld_hld_a;
     opcodes[0xE0] = ldh_n_a_op;
     opcodes[0xF0] = ldh_a_n_op;
+    opcodes[0xE2] = ldh_c_a_op;
+    opcodes[0xF2] = ldh_a_c_op;
     opcodes[0xF9] = ld_sp_hl_op;
     opcodes[0xF8] = ldhl_sp_n_op;
     opcodes[0x08] = ld_nn_sp_op;
@@ -908,7 +967,7 @@ void init_opcodes()
     opcodes[0x4C] = ld_c_h;
     opcodes[0x4D] = ld_c_l;
     opcodes[0x4E] = ld_c_hl;  // LD C,(HL)
-    opcodes[0x4F] = ld_c_a;
+    opcodes[0x4F] = load_c_a;
 
     opcodes[0x50] = ld_d_b;
     opcodes[0x51] = ld_d_c;
@@ -955,7 +1014,7 @@ void init_opcodes()
     opcodes[0x77] = ld_hl_a;  // LD (HL),A
 
     opcodes[0x78] = ld_a_b;
-    opcodes[0x79] = ld_a_c;
+    opcodes[0x79] = load_a_c;
     opcodes[0x7A] = ld_a_d;
     opcodes[0x7B] = ld_a_e;
     opcodes[0x7C] = ld_a_h;
@@ -1056,25 +1115,25 @@ void init_opcodes()
     // Control flow
     // JP
     opcodes[0xC3] = jp_nn_op;
-    opcodes[0xC2] = nop; // jp_nz_nn
-    opcodes[0xCA] = nop; // jp_z_nn
-    opcodes[0xD2] = nop; // jp_nc_nn
-    opcodes[0xDA] = nop; // jp_c_nn
+    opcodes[0xC2] = jp_nz_nn;
+    opcodes[0xCA] = jp_z_nn;
+    opcodes[0xD2] = jp_nc_nn;
+    opcodes[0xDA] = jp_c_nn;
 
     opcodes[0xE9] = jp_hl_op;
 
     opcodes[0x18] = jr_n_op;
-    opcodes[0x20] = nop; // jr_nz_op
-    opcodes[0x28] = nop; // jr_z_op
-    opcodes[0x30] = nop; // jr_nc_op
-    opcodes[0x38] = nop; // jr_c_op
+    opcodes[0x20] = jr_nz_op;
+    opcodes[0x28] = jr_z_op;
+    opcodes[0x30] = jr_nc_op;
+    opcodes[0x38] = jr_c_op;
 
     // CALL
     opcodes[0xCD] = call_nn_op;
-    opcodes[0xC4] = nop; // call_nz_op
-    opcodes[0xCC] = nop; // call_z_op
-    opcodes[0xD4] = nop; // call_nc_op
-    opcodes[0xDC] = nop; // call_c_op
+    opcodes[0xC4] = call_nz_op;
+    opcodes[0xCC] = call_z_op;
+    opcodes[0xD4] = call_nc_op;
+    opcodes[0xDC] = call_c_op;
     
     // PUSH
     opcodes[0xC5] = push_bc;
@@ -1100,10 +1159,10 @@ void init_opcodes()
 
     // RET
     opcodes[0xC9] = ret_op;
-    opcodes[0xC0] = nop; // ret_nz
-    opcodes[0xC8] = nop; // ret_z
-    opcodes[0xD0] = nop; // ret_nc
-    opcodes[0xD8] = nop; // ret_c
+    opcodes[0xC0] = ret_nz;
+    opcodes[0xC8] = ret_z;
+    opcodes[0xD0] = ret_nc;
+    opcodes[0xD8] = ret_c;
     opcodes[0xD9] = reti_op;
 
     // CB-prefixed opcodes
@@ -3,7 +3,7 @@
 
 #include "instructions.h"
 
-typedef void (*Opcode)(CPU*);
+typedef uint8_t (*Opcode)(GB*); // returns cycles taken
 extern Opcode opcodes[256];
 extern Opcode cb_opcodes[256];
 extern const uint8_t opcode_cycles[256];
@@ -1,4 +1,6 @@
 #include "debug.h"
 
+#ifndef STRIP_DEBUG
 uint8_t debug = 0;
 Debug dbg = { 0, 0, 0, 0 };
+#endif
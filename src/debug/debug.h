@@ -10,6 +10,8 @@ typedef struct {
     uint8_t dbg_mem;
 } Debug;
 
+#ifndef STRIP_DEBUG
+
 extern uint8_t debug;
 extern Debug dbg;
 
@@ -17,4 +19,16 @@ extern Debug dbg;
     if (debug) printf(__VA_ARGS__); \
 } while (0)
 
+#else
+
+// Release build: every check folds to a constant 0 and the code behind it is dropped
+static const uint8_t debug = 0;
+static const Debug dbg = { 0, 0, 0, 0 };
+
+#define DBG_PRINT(...) do { \
+    if (0) printf(__VA_ARGS__); \
+} while (0)
+
+#endif
+
 #endif
@@ -1,49 +1,73 @@
 #include "joypad.h"
-#include "../cpu/cpu.h"
+#include "../core/gb.h"
 
-Joypad joypad = { 0xFF, 0xFF };
+static void joypad_event(void* data) { request_interrupt(data, JOYPAD_INT); }
 
-void handle_input(SDL_Event* event)
+static uint8_t joypad_read(GB* gb, uint16_t addr)
 {
+    uint8_t p1 = gb->memory[addr];
+    uint8_t result = 0xCF;
+    
+    if (!(p1 & 0x10))
+        result &= (gb->joypad.dpad | 0xF0);
+    
+    if (!(p1 & 0x20))
+        result &= (gb->joypad.buttons | 0xF0);
+    
+    return result;
+}
+
+void joypad_init(GB* gb)
+{
+    gb->joypad.buttons = 0xFF;
+    gb->joypad.dpad = 0xFF;
+    sched_register(&gb->sched, EVENT_JOYPAD, joypad_event, gb);
+    io_register(gb, ADDR_P1, joypad_read, NULL);
+}
+
+void handle_input(GB* gb, SDL_Event* event)
+{
+    Joypad* joypad = &gb->joypad;
     int pressed = (event->type == SDL_KEYDOWN);
     switch(event->key.keysym.sym)
     {
         // D-pad
         case SDLK_RIGHT:
-            if (pressed) joypad.dpad &= ~DPAD_RIGHT;
-            else joypad.dpad |= DPAD_RIGHT;
+            if (pressed) joypad->dpad &= ~DPAD_RIGHT;
+            else joypad->dpad |= DPAD_RIGHT;
             break;
         case SDLK_LEFT:
-            if (pressed) joypad.dpad &= ~DPAD_LEFT;
-            else joypad.dpad |= DPAD_LEFT;
+            if (pressed) joypad->dpad &= ~DPAD_LEFT;
+            else joypad->dpad |= DPAD_LEFT;
             break;
         case SDLK_UP:
-            if (pressed) joypad.dpad &= ~DPAD_UP;
-            else joypad.dpad |= DPAD_UP;
+            if (pressed) joypad->dpad &= ~DPAD_UP;
+            else joypad->dpad |= DPAD_UP;
             break;
         case SDLK_DOWN:
-            if (pressed) joypad.dpad &= ~DPAD_DOWN;
-            else joypad.dpad |= DPAD_DOWN;
+            if (pressed) joypad->dpad &= ~DPAD_DOWN;
+            else joypad->dpad |= DPAD_DOWN;
             break;
             
         // Buttons
         case SDLK_z:  // A
-            if (pressed) joypad.buttons &= ~BUTTON_A;
-            else joypad.buttons |= BUTTON_A;
+            if (pressed) joypad->buttons &= ~BUTTON_A;
+            else joypad->buttons |= BUTTON_A;
             break;
         case SDLK_x:  // B
-            if (pressed) joypad.buttons &= ~BUTTON_B;
-            else joypad.buttons |= BUTTON_B;
+            if (pressed) joypad->buttons &= ~BUTTON_B;
+            else joypad->buttons |= BUTTON_B;
             break;
         case SDLK_RETURN:  // Start
-            if (pressed) joypad.buttons &= ~BUTTON_START;
-            else joypad.buttons |= BUTTON_START;
+            if (pressed) joypad->buttons &= ~BUTTON_START;
+            else joypad->buttons |= BUTTON_START;
             break;
         case SDLK_RSHIFT:  // Select
-            if (pressed) joypad.buttons &= ~BUTTON_SELECT;
-            else joypad.buttons |= BUTTON_SELECT;
+            if (pressed) joypad->buttons &= ~BUTTON_SELECT;
+            else joypad->buttons |= BUTTON_SELECT;
             break;
     }
+    // Input arrives between frames, the interrupt lands on the next instruction boundary
     if (pressed)
-        request_interrupt(JOYPAD_INT);
+        sched_add(&gb->sched, EVENT_JOYPAD, gb->sched.now);
 }
@@ -9,7 +9,7 @@ typedef struct {
     uint8_t dpad;     // Right, Left, Up, Down (bits 0-3)
 } Joypad;
 
-extern Joypad joypad;
+typedef struct GB GB;
 
 // Button masks
 #define BUTTON_A      0x01
@@ -21,6 +21,7 @@ extern Joypad joypad;
 #define DPAD_UP       0x04
 #define DPAD_DOWN     0x08
 
-void handle_input(SDL_Event* event);
+void joypad_init(GB* gb);
+void handle_input(GB* gb, SDL_Event* event);
 
 #endif
@@ -1,11 +1,92 @@
 #include "ppu.h"
-#include "../cpu/cpu.h"
-#include "../memory/memory.h"
+#include "ppu_simd.h"
+#include "../core/gb.h"
 #include "../debug/debug.h"
 #include <SDL2/SDL.h>
+#include <string.h>
+#include <time.h>
 
-static uint8_t get_background_color_id(PPU *ppu, int x, int y)
+static void ppu_event(void* data);
+
+uint8_t simd_enabled = 1;
+
+// Scalar kernels: the fallback when the CPU has nothing better, and the
+// reference the vector versions are checked against
+static void decode_tile_scalar(const uint8_t* bytes, uint8_t* pixels, uint8_t* flipped)
+{
+    for (int row = 0; row < 8; row++)
+    {
+        uint8_t low = bytes[row * 2];
+        uint8_t high = bytes[row * 2 + 1];
+        for (int px = 0; px < 8; px++)
+        {
+            int bit = 7 - px;
+            pixels[row * 8 + px] = ((high >> bit) & 1) << 1 | ((low >> bit) & 1);
+            flipped[row * 8 + 7 - px] = pixels[row * 8 + px];
+        }
+    }
+}
+
+static void map_palette_scalar(const uint8_t* ids, uint8_t palette, uint8_t* out, int count)
+{
+    for (int i = 0; i < count; i++)
+        out[i] = (palette >> (ids[i] * 2)) & 0x03;
+}
+
+static void expand_rgba_scalar(const uint8_t* shades, const uint32_t* lut, uint32_t* out, int count)
+{
+    for (int i = 0; i < count; i++)
+        out[i] = lut[shades[i]];
+}
+
+static uint8_t sprite_mask_scalar(const uint8_t* pixels, const uint8_t* bg_ids, int behind_bg)
 {
+    uint8_t mask = 0;
+    for (int px = 0; px < 8; px++)
+        if (pixels[px] && !(behind_bg && bg_ids[px]))
+            mask |= 1 << px;
+    return mask;
+}
+
+static const PpuKernels scalar_kernels = {
+    "scalar", decode_tile_scalar, map_palette_scalar, expand_rgba_scalar, sprite_mask_scalar
+};
+static PpuKernels kernels = {
+    "scalar", decode_tile_scalar, map_palette_scalar, expand_rgba_scalar, sprite_mask_scalar
+};
+
+// Once per process, after parse_cli and before any instance renders
+void ppu_select_kernels(void)
+{
+    kernels = scalar_kernels;
+    if (simd_enabled)
+        ppu_simd_select(&kernels);
+}
+
+// Shade 0-3 in each output format
+static const uint32_t colors[4] = {
+    0xFFFFFFFF, // White (lightest)
+    0xAAAAAAFF, // Light gray
+    0x555555FF, // Dark gray
+    0x000000FF  // Black (darkest)
+};
+static const uint16_t colors_565[4] = { 0xFFFF, 0xAD55, 0x52AA, 0x0000 };
+static const uint8_t grays[4] = { 0xFF, 0xAA, 0x55, 0x00 };
+
+// Address of one row of a BG/window tile. Signed mode puts tile 0 at 0x9000.
+static inline uint16_t tile_row_addr(uint8_t lcdc, uint8_t tile_id, int row)
+{
+    uint16_t tile_addr = (lcdc & 0x10) ? 0x8000 + tile_id * 16
+                                       : 0x8800 + ((int8_t)tile_id + 128) * 16;
+    return tile_addr + row * 2;
+}
+
+// Per-pixel reference, kept for --bench-ppu to check the tile-row renderer against
+static uint8_t get_background_color_id(GB* gb, int x, int y)
+{
+    PPU* ppu = &gb->ppu;
+    uint8_t* memory = gb->memory;
+
     // Scroll
     uint16_t bg_x = (x + ppu->SCX) & 0xFF;
     uint16_t bg_y = (y + ppu->SCY) & 0xFF;
@@ -18,34 +99,152 @@ static uint8_t get_background_color_id(PPU *ppu, int x, int y)
     uint16_t tilemap_addr = tilemap_base + tile_y * 32 + tile_x;
 
     uint8_t tile_id = memory[tilemap_addr];
+    uint16_t tile_addr = tile_row_addr(ppu->LCDC, tile_id, bg_y & 7);
+
+    uint8_t low  = memory[tile_addr];
+    uint8_t high = memory[tile_addr + 1];
+
+    int bit = 7 - (bg_x & 7);
+    return ((high >> bit) & 1) << 1 | ((low >> bit) & 1);
+}
 
-    // Tile data base
-    uint8_t unsigned_mode = (ppu->LCDC & 0x10) != 0;
+static void render_window_reference(GB* gb, int y, uint8_t* ids)
+{
+    PPU* ppu = &gb->ppu;
+    uint8_t* memory = gb->memory;
+    int wx = ppu->WX - 7;
+    int wy = ppu->WY;
+    if (y < wy) return;
 
-    uint16_t tile_addr;
+    for (int x = 0; x < 160; x++)
+    {
+        if (x < wx) continue;
+        int win_x = x - wx;
+        int win_y = y - wy;
 
-    tile_addr = unsigned_mode ? 0x8000 + tile_id * 16
-                          : 0x8800 + ((int8_t)tile_id + 128) * 16;
+        uint8_t tile_x = (win_x >> 3) & 31;
+        uint8_t tile_y = (win_y >> 3) & 31;
 
-    // Pixel row inside the tile
-    int row = bg_y & 7;
+        uint16_t tilemap_base = (ppu->LCDC & 0x40) ? 0x9C00 : 0x9800;
+        uint8_t tile_id = memory[tilemap_base + tile_y * 32 + tile_x];
+        uint16_t tile_addr = tile_row_addr(ppu->LCDC, tile_id, win_y & 7);
 
-    uint8_t low  = memory[tile_addr + row * 2];
-    uint8_t high = memory[tile_addr + row * 2 + 1];
+        uint8_t low  = memory[tile_addr];
+        uint8_t high = memory[tile_addr + 1];
 
-    int bit = 7 - (bg_x & 7);
-    return ((high >> bit) & 1) << 1 | ((low >> bit) & 1);
+        int bit = 7 - (win_x & 7);
+        ids[x] = ((high >> bit) & 1) << 1 | ((low >> bit) & 1);
+    }
+}
+
+static void render_bg_reference(GB* gb, int y, uint8_t* ids)
+{
+    for (int x = 0; x < 160; x++)
+        ids[x] = get_background_color_id(gb, x, y);
+}
+
+// Index into the tile cache of a BG/window tile id
+static inline int tile_index(uint8_t lcdc, uint8_t tile_id)
+{
+    return (lcdc & 0x10) ? tile_id : 256 + (int8_t)tile_id;
+}
+
+static void decode_tile(GB* gb, int tile)
+{
+    TileCache* cache = &gb->ppu.tiles;
+    kernels.decode_tile(&gb->memory[VRAM_START + tile * 16], cache->pixels[tile][0], cache->flipped[tile][0]);
+    cache->dirty[tile] = 0;
+}
+
+static inline const uint8_t* tile_pixels(GB* gb, int tile, int row, int flip)
+{
+    TileCache* cache = &gb->ppu.tiles;
+    if (cache->dirty[tile]) decode_tile(gb, tile);
+    return flip ? cache->flipped[tile][row] : cache->pixels[tile][row];
+}
+
+// Emits the tiles of one map row from screen x onwards. The first tile may
+// start left of the screen (x < 0) and the last one is cut at the right edge;
+// everything between is whole tile rows copied out of the cache.
+static void render_tile_row(GB* gb, const uint8_t* map_row, uint8_t lcdc,
+                            uint8_t tile_x, int row, int x, uint8_t* ids)
+{
+    if (x < 0)
+    {
+        const uint8_t* pixels = tile_pixels(gb, tile_index(lcdc, map_row[tile_x & 31]), row, 0);
+        memcpy(ids, pixels - x, 8 + x);
+        x += 8;
+        tile_x++;
+    }
+    for (; x <= 160 - 8; x += 8, tile_x++)
+        memcpy(&ids[x], tile_pixels(gb, tile_index(lcdc, map_row[tile_x & 31]), row, 0), 8);
+    if (x < 160)
+        memcpy(&ids[x], tile_pixels(gb, tile_index(lcdc, map_row[tile_x & 31]), row, 0), 160 - x);
+}
+
+static void render_bg(GB* gb, int y, uint8_t* ids)
+{
+    PPU* ppu = &gb->ppu;
+    uint8_t bg_y = y + ppu->SCY;
+    uint16_t tilemap_base = (ppu->LCDC & 0x08) ? 0x9C00 : 0x9800;
+    const uint8_t* map_row = &gb->memory[tilemap_base + (bg_y >> 3) * 32];
+    render_tile_row(gb, map_row, ppu->LCDC, ppu->SCX >> 3, bg_y & 7, -(ppu->SCX & 7), ids);
+}
+
+static void render_window(GB* gb, int y, uint8_t* ids)
+{
+    PPU* ppu = &gb->ppu;
+    int wx = ppu->WX - 7;
+    if (y < ppu->WY || wx >= 160) return;
+
+    int win_y = y - ppu->WY;
+    uint16_t tilemap_base = (ppu->LCDC & 0x40) ? 0x9C00 : 0x9800;
+    const uint8_t* map_row = &gb->memory[tilemap_base + ((win_y >> 3) & 31) * 32];
+    render_tile_row(gb, map_row, ppu->LCDC, 0, win_y & 7, wx, ids);
 }
 
-static void render_scanline(PPU* ppu)
+// Mode 2: picks each line's sprites. Lower X wins, then lower OAM index, and
+// sprites are appended in OAM order so an insertion on X alone keeps both.
+static void oam_scan(GB* gb)
 {
+    SpriteLists* lists = &gb->ppu.sprites;
+    const uint8_t* oam = &gb->memory[OAM_START];
+    int height = (gb->ppu.LCDC & 0x04) ? 16 : 8;
+
+    memset(lists->count, 0, sizeof(lists->count));
+    for (int i = 0; i < 40; i++)
+    {
+        int top = oam[i * 4] - 16;
+        for (int y = top < 0 ? 0 : top; y < top + height && y < 144; y++)
+        {
+            uint8_t count = lists->count[y];
+            if (count == MAX_LINE_SPRITES) continue;
+
+            uint8_t* index = lists->index[y];
+            int pos = count;
+            while (pos > 0 && oam[index[pos - 1] * 4 + 1] > oam[i * 4 + 1])
+            {
+                index[pos] = index[pos - 1];
+                pos--;
+            }
+            index[pos] = i;
+            lists->count[y] = count + 1;
+        }
+    }
+    lists->dirty = 0;
+}
+
+static void render_scanline(GB* gb)
+{
+    PPU* ppu = &gb->ppu;
+    uint8_t* memory = gb->memory;
+    const uint8_t* oam = &memory[OAM_START];
     int y = ppu->line;
     if (y >= 144) return; // only visible lines
     if (!(ppu->LCDC & 0x80)) 
     {
         // LCD off - display white
-        for (int x = 0; x < 160; x++)
-            ppu->framebuffer[y][x] = 0xFFFFFFFF;
+        memset(ppu->framebuffer[y], 0, 160);
         return;
     }
 
@@ -62,18 +261,11 @@ static void render_scanline(PPU* ppu)
         
         // Check tile data
         uint8_t tile_id = memory[tilemap_base];
-        uint16_t tile_addr;
-        if (ppu->LCDC & 0x10) 
-        {
-            tile_addr = 0x8000 + tile_id * 16;
-        } else 
-        {
-            tile_addr = 0x8800 + ((int8_t)tile_id * 16);
-        }
+        uint16_t tile_addr = tile_row_addr(ppu->LCDC, tile_id, 0);
         DBG_PRINT("First tile address: 0x%04X\n", tile_addr);
         DBG_PRINT("First tile data: %02X %02X\n", memory[tile_addr], memory[tile_addr+1]);
         
-        uint8_t color_id = get_background_color_id(ppu, 0, 0);
+        uint8_t color_id = get_background_color_id(gb, 0, 0);
         DBG_PRINT("First pixel color_id: %d\n", color_id);
         DBG_PRINT("Palette mapping: 0->%d 1->%d 2->%d 3->%d\n",
                (memory[0xFF47] >> 0) & 3,
@@ -82,255 +274,569 @@ static void render_scanline(PPU* ppu)
                (memory[0xFF47] >> 6) & 3);
     }
 
-    uint8_t bg_ids[160]; // for sprite priority
-    uint32_t fb_line[160]; // final RGB values
+    // Padded on both sides for sprites hanging over the edges
+    uint8_t bg_buf[8 + 160 + 8];
+    uint8_t* bg_ids = bg_buf + 8;  // for sprite priority
+    uint8_t* fb_line = ppu->framebuffer[y];
+
+    // Background and window as color ids, then through the palette
+    if (ppu->LCDC & 0x01)
+        render_bg(gb, y, bg_ids);
+    else
+        memset(bg_ids, 0, 160);
+    if (ppu->LCDC & 0x20)
+        render_window(gb, y, bg_ids);
+    memset(bg_buf, 0, 8);
+    memset(&bg_ids[160], 0, 8);
+
+    kernels.map_palette(bg_ids, memory[0xFF47], fb_line, 160);
+
+    // Sprites from the OAM scan, top one first. The first opaque sprite pixel
+    // owns the spot even when it then hides behind the background.
+    if ((ppu->LCDC & 0x02) && ppu->sprites.count[y])
+    {
+        int sprite_height = (ppu->LCDC & 0x04) ? 16 : 8;
+        uint8_t taken_buf[8 + 160 + 8] = { 0 };
+        uint8_t* taken = taken_buf + 8;
 
-    uint8_t bgp = memory[0xFF47];
-    static const uint32_t colors[4] = {
-        0xFFFFFFFF, // White (lightest)
-        0xAAAAAAFF, // Light gray
-        0x555555FF, // Dark gray
-        0x000000FF  // Black (darkest)
-    };
+        for (int n = 0; n < ppu->sprites.count[y]; n++)
+        {
+            const uint8_t* sprite = &oam[ppu->sprites.index[y][n] * 4];
+            int x_spr = sprite[1] - 8;
+            uint8_t tile_id = sprite[2];
+            uint8_t attr = sprite[3];
+            if (x_spr <= -8 || x_spr >= 160) continue;
 
-    // Render background
-    for (int x = 0; x < 160; x++)
-    {
-        uint8_t color_id = 0;
+            int pixel_y = y - (sprite[0] - 16);
+            if (attr & 0x40) pixel_y = sprite_height - 1 - pixel_y; // Y flip
 
-        if (ppu->LCDC & 0x01)
-            color_id = get_background_color_id(ppu, x, y);
+            if (sprite_height == 16) tile_id &= 0xFE;
 
-        // Map color_id through palette
-        uint8_t shade = (bgp >> (color_id * 2)) & 0x03;
-        uint32_t final_color = colors[shade];
+            // X flip comes pre-mirrored from the cache. 8x16 sprites run into the next tile.
+            const uint8_t* pixels = tile_pixels(gb, tile_id + (pixel_y >> 3), pixel_y & 7, attr & 0x20);
+            uint8_t obp = memory[(attr & 0x10) ? 0xFF49 : 0xFF48];
 
-        bg_ids[x] = color_id;
-        fb_line[x] = final_color;
-    }
+            // Transparent pixels and, with OBJ-to-BG priority, pixels over
+            // non-zero background are masked out
+            uint8_t opaque = kernels.sprite_mask(pixels, &bg_ids[x_spr], 0);
+            uint8_t drawn = (attr & 0x80) ? kernels.sprite_mask(pixels, &bg_ids[x_spr], 1) : opaque;
 
-    // Render window (if enabled)
-    if (ppu->LCDC & 0x20) 
-    {
-        int wx = ppu->WX - 7;
-        int wy = ppu->WY;
-        
-        if (y >= wy) 
-        {
-            for (int x = 0; x < 160; x++) 
+            for (int px = 0; px < 8; px++)
             {
-                if (x >= wx) 
-                {
-                    int win_x = x - wx;
-                    int win_y = y - wy;
-
-                    uint8_t tile_x = (win_x >> 3) & 31;
-                    uint8_t tile_y = (win_y >> 3) & 31;
-
-                    uint16_t tilemap_base = (ppu->LCDC & 0x40) ? 0x9C00 : 0x9800;
-                    uint16_t tilemap_addr = tilemap_base + tile_y * 32 + tile_x;
-
-                    uint8_t tile_id = memory[tilemap_addr];
-
-                    uint16_t tile_addr;
-                    if (ppu->LCDC & 0x10) 
-                        tile_addr = 0x8000 + tile_id * 16;
-                    else 
-                    {
-                        int8_t signed_id = (int8_t)tile_id;
-                        tile_addr = 0x8800 + signed_id * 16;
-                    }
-
-                    int row = win_y % 8;
-                    uint8_t low  = memory[tile_addr + row * 2];
-                    uint8_t high = memory[tile_addr + row * 2 + 1];
-
-                    int bit = 7 - (win_x & 7);
-                    uint8_t color_id = ((high >> bit) & 1) << 1 | ((low >> bit) & 1);
-                    
-                    uint8_t shade = (bgp >> (color_id * 2)) & 0x03;
-                    fb_line[x] = colors[shade];
-                    bg_ids[x] = color_id;
-                }
+                int x = x_spr + px;
+                if (x < 0 || x >= 160 || !(opaque & (1 << px)) || taken[x]) continue;
+                taken[x] = 1;
+                if (drawn & (1 << px))
+                    fb_line[x] = (obp >> (pixels[px] * 2)) & 0x03;
             }
         }
     }
+}
 
-    // Render sprites (if enabled)
-    if (ppu->LCDC & 0x02) 
+int ppu_pixel_size(PixelFormat format)
+{
+    switch (format)
     {
-        int sprite_height = (ppu->LCDC & 0x04) ? 16 : 8;
+        case PIXELS_RGBA8888: return 4;
+        case PIXELS_RGB565: return 2;
+        default: return 1;
+    }
+}
 
-        for (int i = 0; i < 40; i++)
+// The frame is kept as shades and only converted here, by whoever consumes it.
+// Lines first to first + count - 1 of frame go to out, pitch bytes apart.
+void ppu_convert_shades(const uint8_t (*frame)[160], PixelFormat format, void* out, int pitch, int first, int count)
+{
+    for (int y = first; y < first + count; y++)
+    {
+        const uint8_t* shades = frame[y];
+        uint8_t* row = (uint8_t*)out + (size_t)(y - first) * pitch;
+        switch (format)
         {
-            uint8_t y_spr = oam[i*4] - 16;
-            uint8_t x_spr = oam[i*4 + 1] - 8;
-            uint8_t tile_id = oam[i*4 + 2];
-            uint8_t attr = oam[i*4 + 3];
-
-            if (y < y_spr || y >= y_spr + sprite_height) continue;
+            case PIXELS_RGBA8888:
+                kernels.expand_rgba(shades, colors, (uint32_t*)row, 160);
+                break;
+            case PIXELS_RGB565:
+                for (int x = 0; x < 160; x++)
+                    ((uint16_t*)row)[x] = colors_565[shades[x]];
+                break;
+            case PIXELS_GRAY8:
+                for (int x = 0; x < 160; x++)
+                    row[x] = grays[shades[x]];
+                break;
+            case PIXELS_INDEX:
+                memcpy(row, shades, 160);
+                break;
+        }
+    }
+}
 
-            int pixel_y = y - y_spr;
-            if (attr & 0x40) pixel_y = sprite_height - 1 - pixel_y; // Y flip
+void ppu_convert_lines(const PPU* ppu, PixelFormat format, void* out, int pitch, int first, int count)
+{
+    ppu_convert_shades(ppu->framebuffer, format, out, pitch, first, count);
+}
 
-            if (sprite_height == 16) tile_id &= 0xFE;
+void ppu_convert_frame(const PPU* ppu, PixelFormat format, void* out, int pitch)
+{
+    ppu_convert_lines(ppu, format, out, pitch, 0, 144);
+}
 
-            uint16_t tile_addr = 0x8000 + tile_id * 16 + pixel_y * 2;
-            uint8_t low  = memory[tile_addr];
-            uint8_t high = memory[tile_addr + 1];
+// Word at a time multiply-xor. The multiply is by an odd number, so a change
+// confined to one word always changes the result.
+static uint64_t hash_line(const uint8_t* line)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (int x = 0; x < 160; x += 8)
+    {
+        uint64_t word;
+        memcpy(&word, line + x, 8);
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    return hash;
+}
 
-            for (int px = 0; px < 8; px++)
-            {
-                int pixel_x = (attr & 0x20) ? 7 - px : px; // X flip
-                uint8_t color_id = ((high >> (7 - pixel_x)) & 1) << 1 | ((low >> (7 - pixel_x)) & 1);
-                if (color_id == 0) continue; // transparent
+static void line_drawn(PPU* ppu, int y)
+{
+    uint64_t hash = hash_line(ppu->framebuffer[y]);
+    if (hash == ppu->lines.hash[y]) return;
+    ppu->lines.hash[y] = hash;
+    if (!ppu->lines.changed[y])
+    {
+        ppu->lines.changed[y] = 1;
+        ppu->lines.count++;
+    }
+}
 
-                int fb_x = x_spr + px;
-                if (fb_x < 0 || fb_x >= 160) continue;
+// Every line counts as changed, for outputs that lost what they showed
+void ppu_mark_changed(PPU* ppu)
+{
+    memset(ppu->lines.changed, 1, sizeof(ppu->lines.changed));
+    ppu->lines.count = 144;
+}
 
-                // Priority: OBJ-to-BG
-                int opaque = (bg_ids[fb_x] != 0);
-                if ((attr & 0x80) && opaque) continue;
+void ppu_clear_changed(PPU* ppu)
+{
+    memset(ppu->lines.changed, 0, sizeof(ppu->lines.changed));
+    ppu->lines.count = 0;
+}
 
-                int palette_index = (attr & 0x10) ? 1 : 0;
-                uint8_t obp = memory[palette_index ? 0xFF49 : 0xFF48];
-                uint8_t shade = (obp >> (color_id * 2)) & 0x03;
-                fb_line[fb_x] = colors[shade];
-            }
+// Converts only the runs of changed lines into the streaming texture, and
+// doesn't present at all when nothing changed
+void render_frame(SDL_Renderer* renderer, SDL_Texture* texture, const uint8_t (*frame)[160], const uint8_t* changed)
+{
+    int drawn = 0;
+    for (int y = 0; y < 144; y++)
+    {
+        if (!changed[y]) continue;
+        int first = y;
+        while (y < 144 && changed[y]) y++;
+
+        SDL_Rect rect = { 0, first, 160, y - first };
+        void* pixels;
+        int pitch;
+        if (SDL_LockTexture(texture, &rect, &pixels, &pitch) == 0)
+        {
+            ppu_convert_shades(frame, PIXELS_RGBA8888, pixels, pitch, first, y - first);
+            SDL_UnlockTexture(texture);
         }
+        drawn = 1;
     }
+    if (!drawn) return;
 
-    // Copy line to framebuffer
-    for (int x = 0; x < 160; x++)
-        ppu->framebuffer[y][x] = fb_line[x];
-}
-
-void render_frame(SDL_Renderer* renderer, SDL_Texture* texture, uint32_t framebuffer[144][160])
-{
-    SDL_UpdateTexture(texture, NULL, framebuffer, 160 * sizeof(uint32_t));
     SDL_RenderClear(renderer);
     SDL_RenderCopy(renderer, texture, NULL, NULL);
     SDL_RenderPresent(renderer);
 }
 
-void ppu_init(PPU *ppu)
+static void lcdc_write(GB* gb, uint16_t addr, uint8_t val)
+{
+    PPU* ppu = &gb->ppu;
+    if (dbg.dbg_mem) 
+        DBG_PRINT("LCDC write: 0x%02X -> 0xFF40 (current LY=%02X)\n", val, gb->memory[0xFF44]);
+    sched_sync(&gb->sched, EVENT_PPU);
+    gb->memory[addr] = val;
+    if ((ppu->LCDC ^ val) & 0x04)
+        ppu->sprites.dirty = 1;
+    // Switched off: the line restarts from mode 2 when it comes back on
+    if ((ppu->LCDC & 0x80) && !(val & 0x80))
+    {
+        ppu->mode = OAM;
+        ppu->mode_clock = 0;
+    }
+    ppu->LCDC = val;
+    sched_sync(&gb->sched, EVENT_PPU);
+}
+
+// Only the interrupt enables are stored, the rest of STAT is built on read
+static void stat_write(GB* gb, uint16_t addr, uint8_t val)
+{
+    gb->memory[addr] = val;
+    gb->ppu.stat = val & 0x78;
+}
+
+static uint8_t stat_read(GB* gb, uint16_t addr)
+{
+    static const uint8_t mode_bits[4] = { 2, 3, 0, 1 };  // OAM, VRAM, HBLANK, VBLANK
+    PPU* ppu = &gb->ppu;
+    uint8_t mode = (ppu->LCDC & 0x80) ? mode_bits[ppu->mode] : 0;
+    uint8_t coincidence = gb->memory[0xFF44] == gb->memory[0xFF45] ? 0x04 : 0;
+    return 0x80 | (gb->memory[addr] & 0x78) | coincidence | mode;
+}
+
+// Lines rendered before the write still see the old value
+static void scroll_write(GB* gb, uint16_t addr, uint8_t val)
+{
+    PPU* ppu = &gb->ppu;
+    sched_sync(&gb->sched, EVENT_PPU);
+    gb->memory[addr] = val;
+    switch (addr)
+    {
+        case 0xFF42: ppu->SCY = val; break;
+        case 0xFF43: ppu->SCX = val; break;
+        case 0xFF4A: ppu->WY = val; break;
+        case 0xFF4B: ppu->WX = val; break;
+    }
+}
+
+// Decided once per frame so a frame is either drawn whole or not at all
+static inline void start_frame(PPU* ppu)
 {
+    ppu->drawing = ppu->render_every && ppu->frame_index % ppu->render_every == 0;
+    ppu->frame_index++;
+}
+
+// Draw one frame in every (1 = all of them), 0 draws nothing. LY, STAT, LYC
+// and the interrupts run exactly the same either way, only pixel work goes.
+void ppu_set_render_rate(GB* gb, uint32_t every)
+{
+    gb->ppu.render_every = every;
+    gb->ppu.frame_index = 0;
+    // The frame in progress finishes as it started, except that 0 stops right away
+    if (!every) gb->ppu.drawing = 0;
+}
+
+// The sink gets the framebuffer while it holds exactly one whole frame, before
+// line 0 of the next one is drawn over it. NULL removes it.
+void ppu_set_frame_sink(GB* gb, FrameSink sink, void* data)
+{
+    gb->ppu.frame_sink = sink;
+    gb->ppu.frame_sink_data = data;
+}
+
+void ppu_init(GB* gb)
+{
+    PPU* ppu = &gb->ppu;
     ppu->mode = OAM;
     ppu->mode_clock = 0;
     ppu->frame_ready = 0;
+    ppu->frame_drawn = 0;
+    ppu->last_sync = gb->sched.now;
     ppu->line = 0;
-    ppu->SCX = 0;
-    ppu->SCY = 0;
-    ppu->WX = 0;
-    ppu->WY = 0;
+    ppu->LCDC = gb->memory[0xFF40];
+    ppu->SCX = gb->memory[0xFF43];
+    ppu->SCY = gb->memory[0xFF42];
+    ppu->WX = gb->memory[0xFF4B];
+    ppu->WY = gb->memory[0xFF4A];
+    ppu->stat = gb->memory[0xFF41] & 0x78;
+    memset(ppu->tiles.dirty, 1, sizeof(ppu->tiles.dirty));
+    ppu->sprites.dirty = 1;
+    ppu->render_every = 1;
+    ppu->frame_index = 0;
+    start_frame(ppu);
 
     // Initialize framebuffer to white
+    memset(ppu->framebuffer, 0, sizeof(ppu->framebuffer));
     for (int y = 0; y < 144; y++)
-        for (int x = 0; x < 160; x++)
-            ppu->framebuffer[y][x] = 0xFFFFFFFF;
+        ppu->lines.hash[y] = hash_line(ppu->framebuffer[y]);
+    ppu_mark_changed(ppu);
+
+    sched_register(&gb->sched, EVENT_PPU, ppu_event, gb);
+    io_register(gb, 0xFF40, NULL, lcdc_write);
+    io_register(gb, 0xFF41, stat_read, stat_write);
+    io_register(gb, 0xFF42, NULL, scroll_write);
+    io_register(gb, 0xFF43, NULL, scroll_write);
+    io_register(gb, 0xFF4A, NULL, scroll_write);
+    io_register(gb, 0xFF4B, NULL, scroll_write);
+    ppu_sync(gb);
 }
 
-void ppu_step(PPU *ppu, int cycles)
+// Called by ppu_sync with exactly the cycles up to the next mode boundary, or fewer
+void ppu_step(GB* gb, int cycles)
 {
-    ppu->LCDC = memory[0xFF40];
-    ppu->SCX = memory[0xFF43];
-    ppu->SCY = memory[0xFF42];
-    ppu->WX = memory[0xFF4B];
-    ppu->WY = memory[0xFF4A];
-    memory[0xFF41] = (memory[0xFF41] & 0xFC) | ppu->mode;
+    PPU* ppu = &gb->ppu;
+    uint8_t* memory = gb->memory;
 
+    if (!(ppu->LCDC & 0x80)) return;
     ppu->mode_clock += cycles;
 
-    if (ppu->LCDC & 0x80)  // LCD enabled
+    switch(ppu->mode)
     {
-        switch(ppu->mode)
-        {
-            case OAM:
-                if (ppu->mode_clock >= 80)
+        case OAM:
+            if (ppu->mode_clock >= 80)
+            {
+                ppu->mode_clock -= 80;
+                if (ppu->drawing && ppu->sprites.dirty)
+                    oam_scan(gb);
+                ppu->mode = VRAM;
+                memory_block_vram(gb, 1);
+            }
+            break;
+            
+        case VRAM:
+            if (ppu->mode_clock >= 172)
+            {
+                ppu->mode_clock -= 172;
+                if (ppu->drawing)
                 {
-                    ppu->mode_clock -= 80;
-                    ppu->mode = VRAM;
-                    memory[0xFF41] = (memory[0xFF41] & 0xFC) | 0x03;  // Mode 3
-                    vram_block = 1;
+                    render_scanline(gb);
+                    line_drawn(ppu, ppu->line);
                 }
-                break;
+                ppu->mode = HBLANK;
+                memory_block_vram(gb, 0);
+
+                // STAT interrupt for HBLANK
+                if (ppu->stat & 0x08)
+                    request_interrupt(gb, STAT_INT);
+            }
+            break;
+            
+        case HBLANK:
+            if (ppu->mode_clock >= 204)
+            {
+                ppu->mode_clock -= 204;
+                ppu->line++;
+                memory[0xFF44] = ppu->line;  // Update LY register
                 
-            case VRAM:
-                if (ppu->mode_clock >= 172)
+                if (ppu->line == 144)  // Last visible scanline
                 {
-                    ppu->mode_clock -= 172;
-                    render_scanline(ppu);
-                    ppu->mode = HBLANK;
-                    memory[0xFF41] = (memory[0xFF41] & 0xFC) | 0x00;  // Mode 0
-                    vram_block = 0;
-
-                    // STAT interrupt for HBLANK
-                    if (memory[0xFF41] & 0x08)
-                        request_interrupt(STAT_INT);
+                    ppu->mode = VBLANK;
+                    request_interrupt(gb, VBLANK_INT);  // VBLANK interrupt
+                    ppu->frame_ready = 1;
+                    ppu->frame_drawn = ppu->drawing;
+                    if (ppu->frame_drawn && ppu->frame_sink)
+                        ppu->frame_sink(ppu->frame_sink_data);
                 }
-                break;
+                else
+                    ppu->mode = OAM;
                 
-            case HBLANK:
-                if (ppu->mode_clock >= 204)
-                {
-                    ppu->mode_clock -= 204;
-                    ppu->line++;
-                    memory[0xFF44] = ppu->line;  // Update LY register
-                    
-                    if (ppu->line == 144)  // Last visible scanline
-                    {
-                        ppu->mode = VBLANK;
-                        request_interrupt(VBLANK_INT);  // VBLANK interrupt
-                        ppu->frame_ready = 1;
-                        memory[0xFF41] = (memory[0xFF41] & 0xFC) | 0x01;  // Mode 1
-                    }
-                    else
-                    {
-                        ppu->mode = OAM;
-                        memory[0xFF41] = (memory[0xFF41] & 0xFC) | 0x02;  // Mode 2
-                    }
-                    
-                    // LY=LYC coincidence interrupt
-                    if (ppu->line == memory[0xFF45] && (memory[0xFF41] & 0x40))
-                        request_interrupt(STAT_INT);
-                }
-                break;
+                // LY=LYC coincidence interrupt
+                if (ppu->line == memory[0xFF45] && (ppu->stat & 0x40))
+                    request_interrupt(gb, STAT_INT);
+            }
+            break;
+            
+        case VBLANK:
+            if (ppu->mode_clock >= 456)
+            {
+                ppu->mode_clock -= 456;
+                ppu->line++;
+                memory[0xFF44] = ppu->line;
                 
-            case VBLANK:
-                if (ppu->mode_clock >= 456)
+                if (ppu->line > 153)  // End of VBLANK
                 {
-                    ppu->mode_clock -= 456;
-                    ppu->line++;
-                    memory[0xFF44] = ppu->line;
-                    
-                    if (ppu->line > 153)  // End of VBLANK
-                    {
-                        ppu->line = 0;
-                        ppu->mode = OAM;
-                        memory[0xFF41] = (memory[0xFF41] & 0xFC) | 0x02;  // Mode 2
-                    }
-                    
-                    // LY=LYC coincidence interrupt
-                    if (ppu->line == memory[0xFF45] && (memory[0xFF41] & 0x40))
-                        request_interrupt(STAT_INT);
+                    ppu->line = 0;
+                    ppu->mode = OAM;
+                    start_frame(ppu);
                 }
-                break;
+                
+                // LY=LYC coincidence interrupt
+                if (ppu->line == memory[0xFF45] && (ppu->stat & 0x40))
+                    request_interrupt(gb, STAT_INT);
+            }
+            break;
+    }
+}
+
+// Cycles ppu_step can take before it changes mode or LY, or raises an interrupt
+uint32_t ppu_cycles_to_event(GB* gb)
+{
+    static const uint16_t mode_length[4] = { 80, 172, 204, 456 }; // OAM, VRAM, HBLANK, VBLANK
+    PPU* ppu = &gb->ppu;
+
+    if (!(ppu->LCDC & 0x80)) return UINT32_MAX;
+    if (ppu->mode_clock >= mode_length[ppu->mode]) return 0;
+    return mode_length[ppu->mode] - ppu->mode_clock;
+}
+
+// Runs the PPU up to the current time, one mode at a time, and queues the next mode change
+void ppu_sync(GB* gb)
+{
+    PPU* ppu = &gb->ppu;
+    uint64_t pending = gb->sched.now - ppu->last_sync;
+    ppu->last_sync = gb->sched.now;
+    while (pending)
+    {
+        uint32_t cycles = ppu_cycles_to_event(gb);
+        if (cycles == UINT32_MAX)  // LCD off, nothing to count
+            break;
+        if (!cycles || cycles > pending) cycles = pending;
+        ppu_step(gb, cycles);
+        pending -= cycles;
+    }
+
+    uint32_t next = ppu_cycles_to_event(gb);
+    if (next == UINT32_MAX)
+        sched_remove(&gb->sched, EVENT_PPU);
+    else
+        sched_add(&gb->sched, EVENT_PPU, gb->sched.now + next);
+}
+
+static void ppu_event(void* data) { ppu_sync(data); }
+
+static double bench_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Renders every visible line's BG (and window, when on) with the given renderers,
+// returns ns per scanline. The checksum keeps the work from being optimized out.
+static double bench_lines(GB* gb, void (*bg)(GB*, int, uint8_t*), void (*win)(GB*, int, uint8_t*),
+                          int rounds, uint32_t* checksum)
+{
+    uint8_t ids[160];
+    double start = bench_seconds();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int y = 0; y < 144; y++)
+        {
+            bg(gb, y, ids);
+            if (gb->ppu.LCDC & 0x20) win(gb, y, ids);
+            *checksum += ids[y] + ids[159 - y];
         }
     }
-    else  // LCD disabled
+    return (bench_seconds() - start) * 1e9 / ((double)rounds * 144);
+}
+
+// Each selected kernel against its scalar version on the current VRAM: every
+// tile decoded, every background line mapped through BGP and masked as a sprite
+static void bench_kernels(GB* gb, int rounds)
+{
+    if (kernels.decode_tile == decode_tile_scalar)
     {
-        // When LCD is off, reset to initial state but still update LY
-        ppu->mode = OAM;
-        ppu->mode_clock = 0;
-        
-        // Basic LY update for boot ROM compatibility
-        if (ppu->mode_clock >= 456) {
-            ppu->mode_clock -= 456;
-            ppu->line++;
-            if (ppu->line > 153) {
-                ppu->line = 0;
+        printf("\nKernels: scalar only%s\n", simd_enabled ? "" : " (--no-simd)");
+        return;
+    }
+
+    const uint8_t* vram = &gb->memory[VRAM_START];
+    uint8_t pixels[2][64], flipped[2][64];
+    int mismatches = 0;
+    for (int tile = 0; tile < TILE_COUNT; tile++)
+    {
+        decode_tile_scalar(vram + tile * 16, pixels[0], flipped[0]);
+        kernels.decode_tile(vram + tile * 16, pixels[1], flipped[1]);
+        mismatches += memcmp(pixels[0], pixels[1], 64) != 0 || memcmp(flipped[0], flipped[1], 64) != 0;
+    }
+
+    static uint8_t ids[144][160 + 8];
+    uint8_t bgp = gb->memory[0xFF47];
+    uint8_t shades[2][160];
+    uint32_t rgba[2][160];
+    for (int y = 0; y < 144; y++)
+    {
+        render_bg(gb, y, ids[y]);
+        memset(&ids[y][160], 0, 8);
+        map_palette_scalar(ids[y], bgp, shades[0], 160);
+        kernels.map_palette(ids[y], bgp, shades[1], 160);
+        mismatches += memcmp(shades[0], shades[1], sizeof(shades[0])) != 0;
+        expand_rgba_scalar(shades[0], colors, rgba[0], 160);
+        kernels.expand_rgba(shades[0], colors, rgba[1], 160);
+        mismatches += memcmp(rgba[0], rgba[1], sizeof(rgba[0])) != 0;
+        for (int x = 0; x < 160; x++)
+            for (int behind = 0; behind <= 0x80; behind += 0x80)
+                mismatches += sprite_mask_scalar(&ids[y][x], &ids[(y + 8) % 144][x], behind)
+                           != kernels.sprite_mask(&ids[y][x], &ids[(y + 8) % 144][x], behind);
+    }
+
+    uint32_t checksum = 0;
+    double time[2][3];
+    for (int k = 0; k < 2; k++)
+    {
+        const PpuKernels* set = k ? &kernels : &scalar_kernels;
+        double start = bench_seconds();
+        for (int r = 0; r < rounds; r++)
+            for (int tile = 0; tile < TILE_COUNT; tile++)
+            {
+                set->decode_tile(vram + tile * 16, pixels[k], flipped[k]);
+                checksum += pixels[k][r & 63] + flipped[k][tile & 63];
+            }
+        time[k][0] = (bench_seconds() - start) * 1e9 / ((double)rounds * TILE_COUNT);
+
+        start = bench_seconds();
+        for (int r = 0; r < rounds; r++)
+            for (int y = 0; y < 144; y++)
+            {
+                set->map_palette(ids[y], bgp, shades[k], 160);
+                checksum += shades[k][y];
+            }
+        time[k][1] = (bench_seconds() - start) * 1e9 / ((double)rounds * 144);
+
+        start = bench_seconds();
+        for (int r = 0; r < rounds; r++)
+            for (int y = 0; y < 144; y++)
+            {
+                set->expand_rgba(ids[y], colors, rgba[k], 160);
+                checksum += rgba[k][y];
             }
-            memory[0xFF44] = ppu->line;
+        time[k][2] = (bench_seconds() - start) * 1e9 / ((double)rounds * 144);
+    }
+
+    printf("\nKernels, scalar against %s: %s (%08X)\n", kernels.name, mismatches ? "MISMATCH" : "match", checksum);
+    printf("  decode tile          scalar %7.1f ns/tile  %-6s %7.1f ns/tile  %.1fx\n",
+           time[0][0], kernels.name, time[1][0], time[0][0] / time[1][0]);
+    printf("  palette              scalar %7.1f ns/line  %-6s %7.1f ns/line  %.1fx\n",
+           time[0][1], kernels.name, time[1][1], time[0][1] / time[1][1]);
+    printf("  RGBA output          scalar %7.1f ns/line  %-6s %7.1f ns/line  %.1fx\n",
+           time[0][2], kernels.name, time[1][2], time[0][2] / time[1][2]);
+}
+
+// --bench-ppu: times the tile-row BG/window renderer against the per-pixel
+// reference on the current VRAM, with and without a window, and checks both
+// draw the same ids. Fine scroll and window x are forced off the tile grid
+// so the partial tiles get exercised.
+void ppu_bench(GB* gb, int rounds)
+{
+    PPU* ppu = &gb->ppu;
+    uint8_t scx = ppu->SCX, lcdc = ppu->LCDC, wx = ppu->WX, wy = ppu->WY;
+    static const struct { const char* name; uint8_t window; } cases[] = {
+        { "background", 0 },
+        { "background + window", 1 },
+    };
+
+    printf("\nScanline renderer, %d rounds of 144 lines:\n", rounds);
+    for (int c = 0; c < 2; c++)
+    {
+        ppu->SCX = scx | 0x03;
+        ppu->LCDC = cases[c].window ? (lcdc | 0x20) : (lcdc & ~0x20);
+        ppu->WX = 7 + 85;
+        ppu->WY = 40;
+
+        int mismatches = 0;
+        for (int y = 0; y < 144; y++)
+        {
+            uint8_t fast[160], ref[160];
+            render_bg(gb, y, fast);
+            render_bg_reference(gb, y, ref);
+            if (cases[c].window)
+            {
+                render_window(gb, y, fast);
+                render_window_reference(gb, y, ref);
+            }
+            mismatches += memcmp(fast, ref, sizeof(fast)) != 0;
         }
+
+        uint32_t checksum = 0;
+        double ref_ns = bench_lines(gb, render_bg_reference, render_window_reference, rounds, &checksum);
+        double fast_ns = bench_lines(gb, render_bg, render_window, rounds, &checksum);
+        printf("  %-20s per-pixel %7.1f ns/line  tile-row %7.1f ns/line  %.1fx  %s (%08X)\n",
+               cases[c].name, ref_ns, fast_ns, ref_ns / fast_ns,
+               mismatches ? "MISMATCH" : "match", checksum);
     }
+    ppu->SCX = scx;
+    ppu->LCDC = lcdc;
+    ppu->WX = wx;
+    ppu->WY = wy;
+
+    bench_kernels(gb, rounds);
 }
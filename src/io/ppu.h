@@ -6,18 +6,80 @@
 
 typedef enum { OAM, VRAM, HBLANK, VBLANK } Mode;
 
+#define TILE_COUNT 384  // 0x8000-0x97FF
+
+// Every VRAM tile decoded to one color id per pixel. memory_write only marks a
+// tile dirty, the renderer decodes it again the next time it draws it.
+typedef struct {
+    uint8_t pixels[TILE_COUNT][8][8];
+    uint8_t flipped[TILE_COUNT][8][8];  // mirrored left to right, for sprites
+    uint8_t dirty[TILE_COUNT];
+} TileCache;
+
+#define MAX_LINE_SPRITES 10
+
+// Result of the mode 2 OAM scan for every visible line: the first 10 sprites
+// in OAM order that cover it, sorted so the one drawn on top comes first.
+// Only rebuilt after OAM or the sprite size changes.
+typedef struct {
+    uint8_t count[144];
+    uint8_t index[144][MAX_LINE_SPRITES];
+    uint8_t dirty;
+} SpriteLists;
+
+// A hash of every visible line as it was last drawn. Lines that come out
+// different get flagged, and stay flagged until whoever shows the frame has
+// taken them with ppu_clear_changed, so unchanged lines and frames can be skipped.
+typedef struct {
+    uint64_t hash[144];
+    uint8_t changed[144];
+    uint8_t count;          // lines flagged in changed
+} LineHashes;
+
+// Called at VBlank, on the emulating thread, after each frame that was drawn
+typedef void (*FrameSink)(void* data);
+
 typedef struct {
     Mode mode;
     uint16_t mode_clock;
     uint16_t line;
-    uint32_t framebuffer[144][160];
+    uint8_t framebuffer[144][160];  // shade 0-3 per pixel, converted on output
     uint8_t SCX, SCY, LCDC;
     uint8_t WX, WY;
+    uint8_t stat;         // STAT interrupt enables, bits 3-6
     uint8_t frame_ready;
+    uint32_t render_every;  // draw one frame in this many, 0 = timing only
+    uint32_t frame_index;
+    uint8_t drawing;        // the current frame's pixels are being rendered
+    uint8_t frame_drawn;    // the frame that last reached VBlank was rendered
+    FrameSink frame_sink;
+    void* frame_sink_data;
+    uint64_t last_sync;   // scheduler time mode_clock is current at
+    TileCache tiles;
+    SpriteLists sprites;
+    LineHashes lines;
 } PPU;
 
-void ppu_init(PPU* ppu);
-void ppu_step(PPU* ppu, int cycles);
-void render_frame(SDL_Renderer* renderer, SDL_Texture* texture, uint32_t framebuffer[144][160]);
+typedef struct GB GB;
+
+typedef enum { PIXELS_RGBA8888, PIXELS_RGB565, PIXELS_GRAY8, PIXELS_INDEX } PixelFormat;
+
+extern uint8_t simd_enabled;
+
+void ppu_select_kernels(void);
+void ppu_init(GB* gb);
+void ppu_set_render_rate(GB* gb, uint32_t every);
+void ppu_set_frame_sink(GB* gb, FrameSink sink, void* data);
+void ppu_step(GB* gb, int cycles);
+uint32_t ppu_cycles_to_event(GB* gb);
+void ppu_sync(GB* gb);
+void ppu_bench(GB* gb, int rounds);
+int ppu_pixel_size(PixelFormat format);
+void ppu_convert_frame(const PPU* ppu, PixelFormat format, void* out, int pitch);
+void ppu_convert_lines(const PPU* ppu, PixelFormat format, void* out, int pitch, int first, int count);
+void ppu_convert_shades(const uint8_t (*frame)[160], PixelFormat format, void* out, int pitch, int first, int count);
+void ppu_mark_changed(PPU* ppu);
+void ppu_clear_changed(PPU* ppu);
+void render_frame(SDL_Renderer* renderer, SDL_Texture* texture, const uint8_t (*frame)[160], const uint8_t* changed);
 
 #endif
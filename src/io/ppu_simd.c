@@ -0,0 +1,208 @@
+#include "ppu_simd.h"
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+
+#define SIMD_TARGETS 1
+
+// Bit masks for pixels 0..7 of a row, both halves of the vector
+#define PIXEL_BITS 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01
+#define PIXEL_BITS_FLIPPED 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
+
+// row holds the low byte 8 times then the high byte 8 times. Each pixel's two
+// bits come out as 1 and 2 in the two halves, which get OR'd together.
+__attribute__((target("sse2")))
+static inline void decode_row_sse2(__m128i row, __m128i mask, uint8_t* out)
+{
+    const __m128i weight = _mm_setr_epi8(1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2);
+    __m128i bits = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(row, mask), mask), weight);
+    _mm_storel_epi64((__m128i*)out, _mm_or_si128(bits, _mm_srli_si128(bits, 8)));
+}
+
+__attribute__((target("sse2")))
+static void decode_tile_sse2(const uint8_t* bytes, uint8_t* pixels, uint8_t* flipped)
+{
+    const __m128i mask = _mm_setr_epi8(PIXEL_BITS, PIXEL_BITS);
+    const __m128i mask_flipped = _mm_setr_epi8(PIXEL_BITS_FLIPPED, PIXEL_BITS_FLIPPED);
+    __m128i v = _mm_loadu_si128((const __m128i*)bytes);
+
+    // Widening each byte to itself three times leaves one row per vector
+    __m128i pairs[2] = { _mm_unpacklo_epi8(v, v), _mm_unpackhi_epi8(v, v) };
+    for (int half = 0; half < 2; half++)
+    {
+        __m128i quads[2] = { _mm_unpacklo_epi16(pairs[half], pairs[half]),
+                             _mm_unpackhi_epi16(pairs[half], pairs[half]) };
+        for (int q = 0; q < 2; q++)
+        {
+            __m128i rows[2] = { _mm_unpacklo_epi32(quads[q], quads[q]),
+                                _mm_unpackhi_epi32(quads[q], quads[q]) };
+            for (int r = 0; r < 2; r++)
+            {
+                int row = half * 4 + q * 2 + r;
+                decode_row_sse2(rows[r], mask, pixels + row * 8);
+                decode_row_sse2(rows[r], mask_flipped, flipped + row * 8);
+            }
+        }
+    }
+}
+
+// Two selects on the bits of each value: bit 0 picks within {0,1} and {2,3},
+// bit 1 picks between the pairs
+__attribute__((target("sse2")))
+static inline __m128i select_sse2(__m128i a, __m128i b, __m128i take_b)
+{
+    return _mm_xor_si128(a, _mm_and_si128(_mm_xor_si128(a, b), take_b));
+}
+
+__attribute__((target("sse2")))
+static void expand_rgba_sse2(const uint8_t* shades, const uint32_t* lut, uint32_t* out, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bit0 = _mm_set1_epi32(1), bit1 = _mm_set1_epi32(2);
+    const __m128i c0 = _mm_set1_epi32((int)lut[0]), c1 = _mm_set1_epi32((int)lut[1]);
+    const __m128i c2 = _mm_set1_epi32((int)lut[2]), c3 = _mm_set1_epi32((int)lut[3]);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        uint32_t four;
+        memcpy(&four, shades + i, 4);
+        __m128i shade = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)four), zero), zero);
+        __m128i odd = _mm_cmpeq_epi32(_mm_and_si128(shade, bit0), bit0);
+        __m128i high = _mm_cmpeq_epi32(_mm_and_si128(shade, bit1), bit1);
+        __m128i rgba = select_sse2(select_sse2(c0, c1, odd), select_sse2(c2, c3, odd), high);
+        _mm_storeu_si128((__m128i*)(out + i), rgba);
+    }
+    for (; i < count; i++)
+        out[i] = lut[shades[i]];
+}
+
+// Same selects on bytes, 16 pixels per step
+__attribute__((target("sse2")))
+static void map_palette_sse2(const uint8_t* ids, uint8_t palette, uint8_t* out, int count)
+{
+    const __m128i bit0 = _mm_set1_epi8(1), bit1 = _mm_set1_epi8(2);
+    __m128i shade[4];
+    for (int id = 0; id < 4; id++)
+        shade[id] = _mm_set1_epi8((palette >> (id * 2)) & 0x03);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i id = _mm_loadu_si128((const __m128i*)(ids + i));
+        __m128i odd = _mm_cmpeq_epi8(_mm_and_si128(id, bit0), bit0);
+        __m128i high = _mm_cmpeq_epi8(_mm_and_si128(id, bit1), bit1);
+        __m128i shades = select_sse2(select_sse2(shade[0], shade[1], odd), select_sse2(shade[2], shade[3], odd), high);
+        _mm_storeu_si128((__m128i*)(out + i), shades);
+    }
+    for (; i < count; i++)
+        out[i] = (palette >> (ids[i] * 2)) & 0x03;
+}
+
+__attribute__((target("sse2")))
+static uint8_t sprite_mask_sse2(const uint8_t* pixels, const uint8_t* bg_ids, int behind_bg)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i transparent = _mm_cmpeq_epi8(_mm_loadl_epi64((const __m128i*)pixels), zero);
+    int hidden = _mm_movemask_epi8(transparent);
+    if (behind_bg)
+        hidden |= ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadl_epi64((const __m128i*)bg_ids), zero));
+    return (uint8_t)~hidden;
+}
+
+// Lane 0 takes rows 0-3 and lane 1 rows 4-7, so the same widening as the SSE2
+// version gives two rows per vector
+__attribute__((target("avx2")))
+static void decode_tile_avx2(const uint8_t* bytes, uint8_t* pixels, uint8_t* flipped)
+{
+    const __m256i mask = _mm256_setr_epi8(PIXEL_BITS, PIXEL_BITS, PIXEL_BITS, PIXEL_BITS);
+    const __m256i mask_flipped = _mm256_setr_epi8(PIXEL_BITS_FLIPPED, PIXEL_BITS_FLIPPED,
+                                                  PIXEL_BITS_FLIPPED, PIXEL_BITS_FLIPPED);
+    const __m256i weight = _mm256_setr_epi8(1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2,
+                                            1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2);
+    __m128i v = _mm_loadu_si128((const __m128i*)bytes);
+    __m256i both = _mm256_inserti128_si256(_mm256_castsi128_si256(v), _mm_srli_si128(v, 8), 1);
+    __m256i pairs = _mm256_unpacklo_epi8(both, both);
+    __m256i quads[2] = { _mm256_unpacklo_epi16(pairs, pairs), _mm256_unpackhi_epi16(pairs, pairs) };
+
+    for (int q = 0; q < 2; q++)
+    {
+        __m256i rows[2] = { _mm256_unpacklo_epi32(quads[q], quads[q]),
+                            _mm256_unpackhi_epi32(quads[q], quads[q]) };
+        for (int r = 0; r < 2; r++)
+        {
+            int row = q * 2 + r;
+            for (int f = 0; f < 2; f++)
+            {
+                __m256i m = f ? mask_flipped : mask;
+                __m256i bits = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(rows[r], m), m), weight);
+                bits = _mm256_or_si256(bits, _mm256_srli_si256(bits, 8));
+                uint8_t* out = f ? flipped : pixels;
+                _mm_storel_epi64((__m128i*)(out + row * 8), _mm256_castsi256_si128(bits));
+                _mm_storel_epi64((__m128i*)(out + (row + 4) * 8), _mm256_extracti128_si256(bits, 1));
+            }
+        }
+    }
+}
+
+// The table sits in a register and each shade picks its dword with a permute
+__attribute__((target("avx2")))
+static void expand_rgba_avx2(const uint8_t* shades, const uint32_t* lut, uint32_t* out, int count)
+{
+    const __m256i palette = _mm256_setr_epi32((int)lut[0], (int)lut[1], (int)lut[2], (int)lut[3],
+                                              (int)lut[0], (int)lut[1], (int)lut[2], (int)lut[3]);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i lo = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(shades + i)));
+        __m256i hi = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(shades + i + 8)));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_permutevar8x32_epi32(palette, lo));
+        _mm256_storeu_si256((__m256i*)(out + i + 8), _mm256_permutevar8x32_epi32(palette, hi));
+    }
+    for (; i < count; i++)
+        out[i] = lut[shades[i]];
+}
+// The 4 shades are a byte shuffle table indexed by the ids themselves
+__attribute__((target("avx2")))
+static void map_palette_avx2(const uint8_t* ids, uint8_t palette, uint8_t* out, int count)
+{
+    const __m256i table = _mm256_setr_epi8(palette & 3, (palette >> 2) & 3, (palette >> 4) & 3, palette >> 6,
+                                           0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                           palette & 3, (palette >> 2) & 3, (palette >> 4) & 3, palette >> 6,
+                                           0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    int i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i id = _mm256_loadu_si256((const __m256i*)(ids + i));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_shuffle_epi8(table, id));
+    }
+    for (; i < count; i++)
+        out[i] = (palette >> (ids[i] * 2)) & 0x03;
+}
+#endif
+
+void ppu_simd_select(PpuKernels* kernels)
+{
+#ifdef SIMD_TARGETS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+    {
+        kernels->name = "SSE2";
+        kernels->decode_tile = decode_tile_sse2;
+        kernels->map_palette = map_palette_sse2;
+        kernels->expand_rgba = expand_rgba_sse2;
+        kernels->sprite_mask = sprite_mask_sse2;
+    }
+    // A sprite row is only 8 bytes, so that one stays SSE2
+    if (__builtin_cpu_supports("avx2"))
+    {
+        kernels->name = "AVX2";
+        kernels->decode_tile = decode_tile_avx2;
+        kernels->map_palette = map_palette_avx2;
+        kernels->expand_rgba = expand_rgba_avx2;
+    }
+#else
+    (void)kernels;
+#endif
+}
@@ -0,0 +1,22 @@
+#ifndef PPU_SIMD_H
+#define PPU_SIMD_H
+
+#include <stdint.h>
+
+// Inner loops of the scanline renderer. ppu.c has the scalar versions, which
+// stay the reference; ppu_simd_select swaps in SSE2/AVX2 ones the CPU supports.
+typedef struct {
+    const char* name;
+    // 16 bytes of 2bpp tile data to 64 color ids, plus the same mirrored left to right
+    void (*decode_tile)(const uint8_t* bytes, uint8_t* pixels, uint8_t* flipped);
+    // Color ids through a BGP/OBP value to shades 0-3
+    void (*map_palette)(const uint8_t* ids, uint8_t palette, uint8_t* out, int count);
+    // Shades to 32-bit pixels through a 4-entry table, for output
+    void (*expand_rgba)(const uint8_t* shades, const uint32_t* lut, uint32_t* out, int count);
+    // Bit n set when sprite pixel n is drawn over bg_ids[n]
+    uint8_t (*sprite_mask)(const uint8_t* pixels, const uint8_t* bg_ids, int behind_bg);
+} PpuKernels;
+
+void ppu_simd_select(PpuKernels* kernels);
+
+#endif
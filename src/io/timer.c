@@ -0,0 +1,89 @@
+#include "timer.h"
+#include "../core/gb.h"
+
+static const int tac_cycles[4] = {1024, 16, 64, 256};
+
+static void timer_tick(GB* gb, uint32_t cycles)
+{
+    Timer* timer = &gb->timer;
+    uint8_t* memory = gb->memory;
+
+    timer->div_counter += cycles;
+    memory[ADDR_DIV] += timer->div_counter / 256;
+    timer->div_counter %= 256;
+
+    if (!(memory[ADDR_TAC] & 0x04)) return;
+
+    uint8_t freq = memory[ADDR_TAC] & 0x03;
+    uint32_t step = tac_cycles[freq];
+    timer->tima_counter += cycles;
+
+    while (timer->tima_counter >= step) 
+    {
+        timer->tima_counter -= step;
+        if (memory[ADDR_TIMA] == 0xFF) 
+        {
+            memory[ADDR_TIMA] = memory[ADDR_TMA];
+            request_interrupt(gb, TIMER_INT);
+        } else 
+        {
+            memory[ADDR_TIMA]++;
+        }
+    }
+}
+
+// Next TIMA overflow, the only timer event that matters to the rest of the system
+static void timer_schedule(GB* gb)
+{
+    uint8_t* memory = gb->memory;
+    if (!(memory[ADDR_TAC] & 0x04))
+    {
+        sched_remove(&gb->sched, EVENT_TIMER);
+        return;
+    }
+    uint32_t step = tac_cycles[memory[ADDR_TAC] & 0x03];
+    uint32_t left = (0x100 - memory[ADDR_TIMA]) * step;
+    left = gb->timer.tima_counter >= left ? 0 : left - gb->timer.tima_counter;
+    sched_add(&gb->sched, EVENT_TIMER, gb->sched.now + left);
+}
+
+// Brings DIV and TIMA up to the current time and requeues the next overflow
+void timer_sync(GB* gb)
+{
+    timer_tick(gb, gb->sched.now - gb->timer.last_sync);
+    gb->timer.last_sync = gb->sched.now;
+    timer_schedule(gb);
+}
+
+static void timer_event(void* data) { timer_sync(data); }
+
+static uint8_t timer_read(GB* gb, uint16_t addr)
+{
+    timer_sync(gb);
+    return gb->memory[addr];
+}
+
+static void timer_write(GB* gb, uint16_t addr, uint8_t val)
+{
+    timer_sync(gb);
+    if (addr == ADDR_DIV)
+    {
+        gb->timer.div_counter = 0;
+        val = 0;
+    }
+    gb->memory[addr] = val;
+    timer_sync(gb);
+}
+
+void timer_init(GB* gb)
+{
+    gb->timer.div_counter = 0;
+    gb->timer.tima_counter = 0;
+    gb->timer.cycle_counter = 0;
+    gb->timer.last_sync = gb->sched.now;
+    sched_register(&gb->sched, EVENT_TIMER, timer_event, gb);
+    io_register(gb, ADDR_DIV, timer_read, timer_write);
+    io_register(gb, ADDR_TIMA, timer_read, timer_write);
+    io_register(gb, ADDR_TMA, NULL, timer_write);
+    io_register(gb, ADDR_TAC, NULL, timer_write);
+}
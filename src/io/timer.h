@@ -0,0 +1,18 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t div_counter;
+    uint32_t tima_counter;
+    uint32_t cycle_counter;
+    uint64_t last_sync;     // scheduler time the counters are current at
+} Timer;
+
+typedef struct GB GB;
+
+void timer_init(GB* gb);
+void timer_sync(GB* gb);
+
+#endif
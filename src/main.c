@@ -2,31 +2,43 @@
 #include "cpu/opcodes.h"
 #include "io/ppu.h"
 #include "core/gb.h"
+#include "core/scheduler.h"
+#include "core/display.h"
+#include "io/joypad.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_render.h>
 
 int main(int argc, char** argv)
 { 
     Options opts = parse_cli(argc, argv);
+    SDL_Context context = { NULL, NULL, NULL };
 
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_TIMER) != 0)
+    if (!opts.headless)
     {
-        fprintf(stderr, "SDL_Init error: %s\n", SDL_GetError());
-        return 1;
+        if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_TIMER) != 0)
+        {
+            fprintf(stderr, "SDL_Init error: %s\n", SDL_GetError());
+            return 1;
+        }
+        context = init_sdl();
     }
-    
-    SDL_Context context = init_sdl();
-    load_game(&opts, argv);
-    
-    CPU cpu;
-    PPU ppu;
 
     init_opcodes();
-    cpu_init(&cpu);
-    ppu_init(&ppu);
-    boot(&cpu, &opts);
-    emu_loop(&cpu, &ppu, &context);
-    cleanup_sdl(&context);
+    ppu_select_kernels();
+    GB* gb = gb_create(&opts);
+    if (!gb)
+    {
+        fprintf(stderr, "Failed to allocate emulator state.\n");
+        return 1;
+    }
+    boot(gb, &opts);
+    if (opts.headless)
+        emu_loop(gb, NULL, &opts);
+    else
+        display_run(&context, gb, &opts);
+    gb_destroy(gb);
+    if (!opts.headless)
+        cleanup_sdl(&context);
     
     return 0;
 }
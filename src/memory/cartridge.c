@@ -0,0 +1,305 @@
+#include "cartridge.h"
+#include "memory.h"
+#include "../core/gb.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int has_battery(uint8_t type)
+{
+    switch (type)
+    {
+        case 0x03: case 0x09: case 0x0F: case 0x10: case 0x13: case 0x1B: case 0x1E:
+            return 1;
+    }
+    return 0;
+}
+
+static MbcType mbc_type(uint8_t type)
+{
+    if (type == 0x00 || type == 0x08 || type == 0x09) return MBC_NONE;
+    if (type >= 0x01 && type <= 0x03) return MBC1;
+    if (type >= 0x0F && type <= 0x13) return MBC3;
+    if (type >= 0x19 && type <= 0x1E) return MBC5;
+    printf("Cartridge type 0x%02X not supported, running it as ROM only.\n", type);
+    return MBC_NONE;
+}
+
+static size_t ram_size(uint8_t code)
+{
+    switch (code)
+    {
+        case 0x01: return 0x800;
+        case 0x02: return 0x2000;
+        case 0x03: return 0x8000;
+        case 0x04: return 0x20000;
+        case 0x05: return 0x10000;
+    }
+    return 0;
+}
+
+static const char* mbc_name(MbcType mbc)
+{
+    switch (mbc)
+    {
+        case MBC1: return "MBC1";
+        case MBC3: return "MBC3";
+        case MBC5: return "MBC5";
+        default: return "ROM only";
+    }
+}
+
+// Battery RAM is a shared mapping of <rom without extension>.sav, so the kernel
+// writes it back on its own and a save costs nothing in the frame loop
+static uint8_t* map_save(const char* rom_path, size_t size)
+{
+    size_t len = strlen(rom_path);
+    char* path = malloc(len + 5);
+    if (!path) return NULL;
+    strcpy(path, rom_path);
+    char* dot = strrchr(path, '.');
+    char* slash = strrchr(path, '/');
+    if (dot && (!slash || dot > slash)) *dot = '\0';
+    strcat(path, ".sav");
+
+    uint8_t* ram = NULL;
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0 && ((size_t)st.st_size >= size || ftruncate(fd, size) == 0))
+    {
+        void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mem != MAP_FAILED)
+        {
+            ram = mem;
+            printf("Battery RAM mapped from %s\n", path);
+        }
+    }
+    if (!ram)
+        fprintf(stderr, "Couldn't map %s, saves won't be kept.\n", path);
+    if (fd >= 0) close(fd);
+    free(path);
+    return ram;
+}
+
+// Files that aren't whole banks get copied into a padded buffer so every page
+// the table can point at exists
+static const uint8_t* copy_rom(int fd, size_t size, size_t* padded)
+{
+    size_t banks = (size + ROM_BANK_SIZE - 1) / ROM_BANK_SIZE;
+    if (banks < 2) banks = 2;
+    uint8_t* rom = malloc(banks * ROM_BANK_SIZE);
+    if (!rom) return NULL;
+    memset(rom, 0xFF, banks * ROM_BANK_SIZE);
+
+    size_t done = 0;
+    while (done < size)
+    {
+        ssize_t got = read(fd, rom + done, size - done);
+        if (got <= 0) break;
+        done += got;
+    }
+    if (done != size)
+    {
+        free(rom);
+        return NULL;
+    }
+    *padded = banks * ROM_BANK_SIZE;
+    return rom;
+}
+
+static void update_banks(Cartridge* cart)
+{
+    uint16_t rom = cart->rom_reg;
+    uint16_t rom0 = 0;
+    uint8_t ram = cart->ram_reg;
+    switch (cart->mbc)
+    {
+        case MBC1:
+            // The 2-bit register extends the ROM bank, and in mode 1 also picks
+            // the bank at 0x0000 and the RAM bank
+            rom = (cart->ram_reg << 5) | cart->rom_reg;
+            rom0 = cart->mode ? (cart->ram_reg << 5) : 0;
+            ram = cart->mode ? cart->ram_reg : 0;
+            break;
+        case MBC3:
+        case MBC5:
+            break;
+        default:
+            rom = 1;
+            ram = 0;
+            break;
+    }
+    cart->rom_bank = rom % cart->rom_banks;
+    cart->rom_bank0 = rom0 % cart->rom_banks;
+    cart->ram_bank = ram % cart->ram_banks;
+}
+
+int cartridge_load(Cartridge* cart, const char* path)
+{
+    memset(cart, 0, sizeof(Cartridge));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    size_t size = st.st_size;
+    if (size >= 2 * ROM_BANK_SIZE && size % ROM_BANK_SIZE == 0)
+    {
+        void* rom = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (rom != MAP_FAILED)
+        {
+            cart->rom = rom;
+            cart->rom_size = size;
+            cart->rom_mapped = 1;
+        }
+    }
+    if (!cart->rom)
+        cart->rom = copy_rom(fd, size, &cart->rom_size);
+    close(fd);
+    if (!cart->rom) return -1;
+
+    cart->rom_banks = cart->rom_size / ROM_BANK_SIZE;
+    cart->mbc = mbc_type(cart->rom[ADDR_CART_TYPE]);
+    cart->ram_size = ram_size(cart->rom[ADDR_RAM_SIZE]);
+    if (cart->mbc == MBC3 && cart->ram_size > 0x8000) cart->ram_size = 0x8000;
+    if (cart->ram_size)
+    {
+        // Smaller than a bank still gets a whole one so the pages stay valid
+        size_t alloc = cart->ram_size < RAM_BANK_SIZE ? RAM_BANK_SIZE : cart->ram_size;
+        if (has_battery(cart->rom[ADDR_CART_TYPE]))
+            cart->ram = map_save(path, alloc);
+        cart->ram_saved = cart->ram != NULL;
+        if (!cart->ram)
+            cart->ram = calloc(1, alloc);
+        if (!cart->ram)
+        {
+            cartridge_free(cart);
+            return -1;
+        }
+        cart->ram_banks = alloc / RAM_BANK_SIZE;
+    }
+    else
+        cart->ram_banks = 1;
+
+    cart->save_on_disable = 1;
+    cart->ram_enabled = cart->mbc == MBC_NONE;
+    cart->rom_reg = 1;
+    update_banks(cart);
+
+    printf("Cartridge: %s, %u ROM banks, %zu KB RAM\n", mbc_name(cart->mbc), cart->rom_banks, cart->ram_size / 1024);
+    return 0;
+}
+
+void cartridge_free(Cartridge* cart)
+{
+    if (cart->rom_mapped)
+        munmap((void*)cart->rom, cart->rom_size);
+    else
+        free((void*)cart->rom);
+    if (cart->ram_saved)
+    {
+        cartridge_sync(cart, 1);
+        munmap(cart->ram, cart->ram_banks * RAM_BANK_SIZE);
+    }
+    else
+        free(cart->ram);
+    cart->rom = NULL;
+    cart->ram = NULL;
+}
+
+// Asks the kernel to write the save back; only waits for it when told to
+void cartridge_sync(Cartridge* cart, int wait)
+{
+    if (cart->ram_saved)
+        msync(cart->ram, cart->ram_banks * RAM_BANK_SIZE, wait ? MS_SYNC : MS_ASYNC);
+}
+
+const uint8_t* cartridge_rom_page(const Cartridge* cart, uint8_t page)
+{
+    uint16_t bank = page < (ROMX_START >> 8) ? cart->rom_bank0 : cart->rom_bank;
+    return cart->rom + (size_t)bank * ROM_BANK_SIZE + ((page & 0x3F) << 8);
+}
+
+// NULL while RAM is disabled, missing or an MBC3 clock register is selected
+uint8_t* cartridge_ram_page(const Cartridge* cart, uint8_t page)
+{
+    if (!cart->ram || !cart->ram_enabled) return NULL;
+    if (cart->mbc == MBC3 && cart->ram_reg >= 0x08) return NULL;
+    return cart->ram + (size_t)cart->ram_bank * RAM_BANK_SIZE + ((page & 0x1F) << 8);
+}
+
+uint8_t cartridge_read(GB* gb, uint16_t addr)
+{
+    Cartridge* cart = &gb->cart;
+    if (addr < VRAM_START)
+        return cartridge_rom_page(cart, addr >> 8)[addr & 0xFF];
+
+    uint8_t* page = cartridge_ram_page(cart, addr >> 8);
+    if (page) return page[addr & 0xFF];
+    if (cart->mbc == MBC3 && cart->ram_enabled && cart->ram_reg >= 0x08 && cart->ram_reg <= 0x0C)
+        return cart->rtc[cart->ram_reg - 0x08];
+    return 0xFF;
+}
+
+// ROM writes go to the MBC registers. Every bank change just repoints the pages.
+void cartridge_write(GB* gb, uint16_t addr, uint8_t val)
+{
+    Cartridge* cart = &gb->cart;
+    if (addr >= EXTRAM_START)
+    {
+        uint8_t* page = cartridge_ram_page(cart, addr >> 8);
+        if (page)
+            page[addr & 0xFF] = val;
+        else if (cart->mbc == MBC3 && cart->ram_enabled && cart->ram_reg >= 0x08 && cart->ram_reg <= 0x0C)
+            cart->rtc[cart->ram_reg - 0x08] = val;
+        return;
+    }
+    if (cart->mbc == MBC_NONE) return;
+
+    uint16_t rom_bank0 = cart->rom_bank0, rom_bank = cart->rom_bank;
+    uint8_t ram_enabled = cart->ram_enabled, ram_bank = cart->ram_bank, ram_reg = cart->ram_reg;
+    switch (addr >> 13)
+    {
+        case 0:  // 0x0000-0x1FFF
+            cart->ram_enabled = (val & 0x0F) == 0x0A;
+            if (ram_enabled && !cart->ram_enabled && cart->save_on_disable)
+                cartridge_sync(cart, 0);
+            break;
+        case 1:  // 0x2000-0x3FFF
+            if (cart->mbc == MBC1)
+                cart->rom_reg = (val & 0x1F) ? (val & 0x1F) : 1;
+            else if (cart->mbc == MBC3)
+                cart->rom_reg = (val & 0x7F) ? (val & 0x7F) : 1;
+            else if (addr < 0x3000)
+                cart->rom_reg = (cart->rom_reg & 0x100) | val;
+            else
+                cart->rom_reg = (cart->rom_reg & 0xFF) | ((val & 1) << 8);
+            break;
+        case 2:  // 0x4000-0x5FFF
+            cart->ram_reg = val & (cart->mbc == MBC1 ? 0x03 : 0x0F);
+            break;
+        case 3:  // 0x6000-0x7FFF
+            if (cart->mbc == MBC1)
+                cart->mode = val & 1;
+            else if (cart->mbc == MBC3)
+                cart->rtc_latch = val;
+            break;
+    }
+    update_banks(cart);
+
+    if (cart->rom_bank0 != rom_bank0)
+        memory_remap(gb, ROM0_START >> 8, ROM0_END >> 8);
+    if (cart->rom_bank != rom_bank)
+        memory_remap(gb, ROMX_START >> 8, ROMX_END >> 8);
+    if (cart->ram_enabled != ram_enabled || cart->ram_bank != ram_bank || cart->ram_reg != ram_reg)
+        memory_remap(gb, EXTRAM_START >> 8, EXTRAM_END >> 8);
+}
@@ -0,0 +1,53 @@
+#ifndef CARTRIDGE_H
+#define CARTRIDGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ROM_BANK_SIZE 0x4000
+#define RAM_BANK_SIZE 0x2000
+
+// Cartridge header
+#define ADDR_CART_TYPE 0x0147
+#define ADDR_ROM_SIZE  0x0148
+#define ADDR_RAM_SIZE  0x0149
+
+typedef struct GB GB;
+
+typedef enum { MBC_NONE, MBC1, MBC3, MBC5 } MbcType;
+
+typedef struct {
+    const uint8_t* rom;     // the ROM file, mapped read-only
+    size_t rom_size;        // whole banks
+    uint16_t rom_banks;
+    uint8_t rom_mapped;     // 0 when the file had to be copied and padded instead
+    uint8_t* ram;
+    size_t ram_size;
+    uint8_t ram_banks;
+    uint8_t ram_saved;      // ram is a shared mapping of the .sav file
+    uint8_t save_on_disable;  // msync when the game disables RAM after saving
+    MbcType mbc;
+
+    // Registers as the game wrote them
+    uint8_t ram_enabled;
+    uint16_t rom_reg;       // MBC1: low 5 bits, MBC3: 7 bits, MBC5: 9 bits
+    uint8_t ram_reg;        // MBC1: upper 2 bits, MBC3: RAM bank or RTC register
+    uint8_t mode;           // MBC1 banking mode
+    uint8_t rtc[5];         // MBC3 clock registers, kept but not ticking
+    uint8_t rtc_latch;
+
+    // Banks currently visible at 0x0000, 0x4000 and 0xA000
+    uint16_t rom_bank0;
+    uint16_t rom_bank;
+    uint8_t ram_bank;
+} Cartridge;
+
+int cartridge_load(Cartridge* cart, const char* path);
+void cartridge_free(Cartridge* cart);
+void cartridge_sync(Cartridge* cart, int wait);
+const uint8_t* cartridge_rom_page(const Cartridge* cart, uint8_t page);
+uint8_t* cartridge_ram_page(const Cartridge* cart, uint8_t page);
+uint8_t cartridge_read(GB* gb, uint16_t addr);
+void cartridge_write(GB* gb, uint16_t addr, uint8_t val);
+
+#endif
@@ -1,108 +1,258 @@
 #include "memory.h"
-#include "../io/joypad.h"
-#include "../cpu/cpu.h"
+#include "../core/gb.h"
 #include "../debug/debug.h"
 
-uint8_t memory[MEM_SIZE];
-uint8_t boot_rom[256];
-uint8_t* vram = &memory[VRAM_START]; 
-uint8_t* oam = &memory[OAM_START];
+#define SERIAL_TRANSFER_CYCLES 4096  // 8 bits at 8192 Hz
 
-uint8_t bootstrap_enabled = 0;
-uint8_t vram_block = 0;
-uint16_t current_pc_debug = 0;
+// Echo RAM pages show the WRAM page 0x2000 below them
+static inline uint8_t mirror_page(uint8_t page)
+{
+    return (page >= (ECHO_START >> 8) && page <= (ECHO_END >> 8)) ? page - 0x20 : page;
+}
+
+static inline int extram_page(uint8_t page) { return page >= (EXTRAM_START >> 8) && page <= (EXTRAM_END >> 8); }
+
+// Tile data has to go through memory_write so the decoded tile gets marked dirty
+static inline int tile_page(uint8_t page) { return page >= (VRAM_START >> 8) && page <= (TILESET2_END >> 8); }
+
+static void map_page(GB* gb, uint8_t page)
+{
+    uint8_t* bytes = &gb->memory[mirror_page(page) << 8];
+    const uint8_t* read = bytes;
+    uint8_t* write = bytes;
+
+    if (page < (VRAM_START >> 8))
+    {
+        read = cartridge_rom_page(&gb->cart, page);
+        write = NULL;  // MBC registers
+    }
+    if (extram_page(page)) read = write = cartridge_ram_page(&gb->cart, page);
+    if (page == 0x00 && gb->bootstrap_enabled) read = gb->boot_rom;
+    if (gb->vram_block && page >= (VRAM_START >> 8) && page <= (VRAM_END >> 8)) read = write = NULL;
+    if (gb->dma.active && page == (OAM_START >> 8)) read = write = NULL;
+    if (page == (OAM_START >> 8)) write = NULL;  // the PPU's sprite lists follow OAM
+    if (page == (IO_START >> 8)) read = write = NULL;  // HRAM shares its page with the registers
+    // Writes have to drop cached code, and DMA has to copy its source before it changes
+    if (tile_page(page)) write = NULL;
+    if (gb->blocks.code_pages[mirror_page(page)]) write = NULL;
+    if (gb->dma.active && mirror_page(gb->dma.src >> 8) == mirror_page(page)) write = NULL;
+    if (dbg.dbg_mem) write = NULL;
 
-DMA dma = { 0, 0, 0 };
+    gb->map.read[page] = read;
+    gb->map.write[page] = write;
+}
 
-void write_byte(uint16_t addr, uint8_t val)
+// Call after anything map_page looks at changes. Echo pages follow their WRAM page.
+void memory_remap(GB* gb, uint8_t first_page, uint8_t last_page)
 {
-    if (dbg.dbg_mem && current_pc_debug >= 0x0090 && current_pc_debug <= 0x00B0) 
+    for (int page = first_page; page <= last_page; page++)
     {
-        DBG_PRINT("WRITE: PC=%04X writing 0x%02X to 0x%04X\n", current_pc_debug, val, addr);
+        map_page(gb, page);
+        if (page >= (WRAM_START >> 8) && page + 0x20 <= (ECHO_END >> 8))
+            map_page(gb, page + 0x20);
     }
-    if (addr == ADDR_DIV) 
+}
+
+// Mode 3 flips this twice per line, so it only rewrites the VRAM entries
+void memory_block_vram(GB* gb, uint8_t blocked)
+{
+    gb->vram_block = blocked;
+    if (!blocked && (gb->dma.active || dbg.dbg_mem))
     {
-        cpu_timer.div_counter = 0;
-        memory[addr] = 0;
+        memory_remap(gb, VRAM_START >> 8, VRAM_END >> 8);
         return;
     }
-    if (addr == 0xFF46)  // DMA transfer
+    for (int page = VRAM_START >> 8; page <= VRAM_END >> 8; page++)
     {
-        memory[addr] = val;
-        dma.active = 1;
-        dma.src = val << 8;
-        dma.index = 0;
-        return;
+        uint8_t* bytes = blocked ? NULL : &gb->memory[page << 8];
+        gb->map.read[page] = bytes;
+        gb->map.write[page] = tile_page(page) ? NULL : bytes;
     }
-    if (addr == 0xFF40) 
+}
+
+static void remap_dma(GB* gb)
+{
+    uint8_t src = mirror_page(gb->dma.src >> 8);
+    memory_remap(gb, src, src);
+    memory_remap(gb, OAM_START >> 8, OAM_START >> 8);
+}
+
+static uint8_t io_read_plain(GB* gb, uint16_t addr) { return gb->memory[addr]; }
+static void io_write_plain(GB* gb, uint16_t addr, uint8_t val) { gb->memory[addr] = val; }
+
+// NULL keeps the plain handler for that direction
+void io_register(GB* gb, uint16_t addr, IoRead read, IoWrite write)
+{
+    gb->io.read[addr - IO_START] = read ? read : io_read_plain;
+    gb->io.write[addr - IO_START] = write ? write : io_write_plain;
+}
+
+// OAM is off limits to the CPU between the first and the last byte
+static inline int dma_locked(GB* gb)
+{
+    return gb->dma.active && gb->sched.now >= gb->dma.start && gb->sched.now < gb->dma.end;
+}
+
+// Nothing is copied yet: the whole block goes over in dma_sync, normally once
+// from the end-of-transfer event
+static void dma_write(GB* gb, uint16_t addr, uint8_t val)
+{
+    gb->memory[addr] = val;
+    // A restart drops the transfer in progress, so its source page goes back to plain memory
+    if (gb->dma.active)
     {
-        if (dbg.dbg_mem) 
-            DBG_PRINT("LCDC write: 0x%02X -> 0xFF40 (current LY=%02X)\n", val, memory[0xFF44]);
-        memory[addr] = val;
+        gb->dma.active = 0;
+        remap_dma(gb);
+    }
+    gb->dma.active = 1;
+    gb->dma.src = val << 8;
+    gb->dma.index = 0;
+    gb->dma.start = gb->sched.now + DMA_START_DELAY;
+    gb->dma.end = gb->dma.start + DMA_BYTES * DMA_CYCLES_PER_BYTE;
+    remap_dma(gb);
+    sched_add(&gb->sched, EVENT_DMA, gb->dma.end);
+}
+
+static void serial_write(GB* gb, uint16_t addr, uint8_t val)
+{
+    gb->memory[addr] = val;
+    if (val != 0x81) return;
+
+    char c = gb->memory[0xFF01];
+    if (c >= 32 && c <= 126)
+        putchar(c);
+    else if (c == '\n' || c == '\r') 
+        putchar('\n');
+    fflush(stdout);
+    sched_add(&gb->sched, EVENT_SERIAL, gb->sched.now + SERIAL_TRANSFER_CYCLES);
+}
+
+static void boot_rom_write(GB* gb, uint16_t addr, uint8_t val)
+{
+    if (!gb->bootstrap_enabled)
+    {
+        gb->memory[addr] = val;
         return;
     }
-    if (addr == 0xFF02 && val == 0x81)
+    gb->bootstrap_enabled = 0;
+    memory_remap(gb, 0x00, 0x00);
+    printf("Boot ROM disabled.\n");
+}
+
+void memory_write(GB* gb, uint16_t addr, uint8_t val)
+{
+    uint8_t* memory = gb->memory;
+
+    if (dbg.dbg_mem && gb->current_pc_debug >= 0x0090 && gb->current_pc_debug <= 0x00B0) 
+    {
+        DBG_PRINT("WRITE: PC=%04X writing 0x%02X to 0x%04X\n", gb->current_pc_debug, val, addr);
+    }
+
+    // OAM DMA copies lazily, so bring it up to date before its source changes
+    // under it, either by a store or by a bank switch
+    if (gb->dma.active && (addr < VRAM_START || addr == 0xFF46
+                           || mirror_page(addr >> 8) == mirror_page(gb->dma.src >> 8)))
+        dma_sync(gb);
+
+    if (addr >= IO_START && addr <= IO_END)
     {
-        char c = memory[0xFF01];
-        if (c >= 32 && c <= 126)
-            putchar(c);
-        else if (c == '\n' || c == '\r') 
-            putchar('\n');
-        fflush(stdout);
-        memory[0xFF02] = 0;
+        gb->io.write[addr - IO_START](gb, addr, val);
         return;
     }
-    if (addr == 0xFF50 && bootstrap_enabled)
+    if (addr < VRAM_START || (addr >= EXTRAM_START && addr <= EXTRAM_END))
     {
-        bootstrap_enabled = 0;
-        printf("Boot ROM disabled.\n");
+        cartridge_write(gb, addr, val);
+        if (dbg.dbg_mem && (addr == 0xA000 || addr == 0xA001))
+            DBG_PRINT("\n[Test wrote 0x%02X to 0x%04X]\n", val, addr);
         return;
     }
-    
+    if (addr >= ECHO_START && addr <= ECHO_END) addr -= 0x2000;
+
     // Block writes to VRAM/OAM during DMA (optional - not critical)
-    if  (vram_block && addr >= VRAM_START && addr < 0xA000) return;
-    if (dma.active && addr >= OAM_START && addr < 0xFEA0) return;
+    if  (gb->vram_block && addr >= VRAM_START && addr < 0xA000) return;
+    if (addr >= OAM_START && addr <= OAM_END)
+    {
+        if (dma_locked(gb)) return;
+        gb->ppu.sprites.dirty = 1;
+    }
+    if (addr <= TILESET2_END && addr >= VRAM_START && memory[addr] != val)
+        gb->ppu.tiles.dirty[(addr - VRAM_START) >> 4] = 1;
     
     memory[addr] = val;
-
-    if (dbg.dbg_mem && (addr == 0xA000 || addr == 0xA001))
-        DBG_PRINT("\n[Test wrote 0x%02X to 0x%04X]\n", val, addr);
+    if (gb->blocks.code_pages[addr >> 8])
+        block_invalidate(gb, addr);
 }
 
-uint8_t read_byte(uint16_t addr) 
+uint8_t memory_read(GB* gb, uint16_t addr)
 {
-    if (bootstrap_enabled && addr < 0x0100)
-        return boot_rom[addr];
+    if (gb->bootstrap_enabled && addr < 0x0100)
+        return gb->boot_rom[addr];
+    if (addr >= HRAM_START)
+        return gb->memory[addr];
+    if (addr >= IO_START)
+        return gb->io.read[addr - IO_START](gb, addr);
     
-    if (addr == ADDR_DIV) 
-        return (cpu_timer.div_counter >> 8) & 0xFF;
+    // Block reads from VRAM/OAM during DMA
+    if (addr >= OAM_START && addr <= OAM_END && dma_locked(gb)) return 0xFF;
+    if (gb->vram_block && addr >= 0x8000 && addr < 0xA000) return 0xFF;
+    if (addr < VRAM_START || (addr >= EXTRAM_START && addr <= EXTRAM_END))
+        return cartridge_read(gb, addr);
+    if (addr >= ECHO_START && addr <= ECHO_END) addr -= 0x2000;
     
-    if (addr == ADDR_P1)
+    return gb->memory[addr];
+}
+
+// Copies whatever the transfer would have copied by now in one go
+void dma_sync(GB* gb)
+{
+    DMA* dma = &gb->dma;
+    if (!dma->active) return;
+    uint64_t now = gb->sched.now;
+    uint32_t done = now <= dma->start ? 0 : (now - dma->start) / DMA_CYCLES_PER_BYTE;
+    if (done > DMA_BYTES) done = DMA_BYTES;
+
+    if (done > dma->index)
     {
-        uint8_t p1 = memory[ADDR_P1];
-        uint8_t result = 0xCF;
-        
-        if (!(p1 & 0x10))
-            result &= (joypad.dpad | 0xF0);
-        
-        if (!(p1 & 0x20))
-            result &= (joypad.buttons | 0xF0);
-        
-        return result;
+        uint8_t page = mirror_page(dma->src >> 8);
+        const uint8_t* src = &gb->memory[page << 8];
+        if (page < (VRAM_START >> 8)) src = cartridge_rom_page(&gb->cart, page);
+        if (extram_page(page)) src = cartridge_ram_page(&gb->cart, page);
+        uint8_t* oam = &gb->memory[OAM_START];
+        if (src)
+            memcpy(oam + dma->index, src + dma->index, done - dma->index);
+        else
+            memset(oam + dma->index, 0xFF, done - dma->index);
+        dma->index = done;
+        gb->ppu.sprites.dirty = 1;
+    }
+    if (now >= dma->end)
+    {
+        dma->active = 0;
+        remap_dma(gb);
+        sched_remove(&gb->sched, EVENT_DMA);
     }
-    
-    // Block reads from VRAM/OAM during DMA
-    if (dma.active && addr >= 0xFE00 && addr < 0xFEA0) return 0xFF;
-    if (vram_block && addr >= 0x8000 && addr < 0xA000) return 0xFF;
-    
-    return memory[addr];
 }
 
-void dma_step() 
-{ 
-    if (!dma.active) return; 
-    oam[dma.index] = memory[dma.src + dma.index]; 
-    dma.index++; 
-    if (dma.index == 0xA0) dma.active = 0; 
+static void dma_event(void* data) { dma_sync(data); }
+
+// No link partner: the transfer shifts in 0xFF and finishes with an interrupt
+static void serial_event(void* data)
+{
+    GB* gb = data;
+    gb->memory[0xFF01] = 0xFF;
+    gb->memory[0xFF02] &= 0x7F;
+    request_interrupt(gb, SERIAL_INT);
 }
 
+void memory_init(GB* gb)
+{
+    gb->dma.active = 0;
+    memory_remap(gb, 0x00, 0xFF);
+    for (uint16_t addr = IO_START; addr <= IO_END; addr++)
+        io_register(gb, addr, NULL, NULL);
+    io_register(gb, 0xFF02, NULL, serial_write);
+    io_register(gb, 0xFF46, NULL, dma_write);
+    io_register(gb, 0xFF50, NULL, boot_rom_write);
+    sched_register(&gb->sched, EVENT_DMA, dma_event, gb);
+    sched_register(&gb->sched, EVENT_SERIAL, serial_event, gb);
+}
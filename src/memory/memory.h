@@ -5,14 +5,8 @@
 #include <string.h>
 
 #define MEM_SIZE 65536
-extern uint8_t memory[MEM_SIZE];
-extern uint8_t boot_rom[256];
-extern uint8_t* vram;
-extern uint8_t* oam;
 
-extern uint8_t bootstrap_enabled;
-extern uint8_t vram_block;
-extern uint16_t current_pc_debug;
+typedef struct GB GB;
 
 // Timer / Divider registers
 #define ADDR_DIV   0xFF04  // Divider
@@ -48,16 +42,43 @@ extern uint16_t current_pc_debug;
 // Joypad
 #define ADDR_P1 0xFF00
 
+// OAM DMA: 160 bytes, one per M-cycle, starting one M-cycle after the write to 0xFF46
+#define DMA_BYTES 0xA0
+#define DMA_CYCLES_PER_BYTE 4
+#define DMA_START_DELAY 4
+
 typedef struct {
     uint8_t active;
     uint16_t src;
-    uint8_t index;
+    uint8_t index;    // bytes already copied
+    uint64_t start;   // scheduler time of the first byte
+    uint64_t end;     // scheduler time OAM is released
 } DMA;
 
-extern DMA dma;
+// One entry per 256-byte page pointing at the bytes backing it, or NULL when
+// accesses have side effects and have to go through memory_read/memory_write.
+// read_byte and write_byte in core/gb.h try the table first.
+typedef struct {
+    const uint8_t* read[256];
+    uint8_t* write[256];
+} PageTable;
+
+// Handlers for the IO registers 0xFF00-0xFF7F, registered by the component that
+// owns each one. Unregistered registers just store and return the byte.
+typedef uint8_t (*IoRead)(GB* gb, uint16_t addr);
+typedef void (*IoWrite)(GB* gb, uint16_t addr, uint8_t val);
+
+typedef struct {
+    IoRead read[0x80];
+    IoWrite write[0x80];
+} IoTable;
 
-void write_byte(uint16_t addr, uint8_t val);
-uint8_t read_byte(uint16_t addr);
-void dma_step();
+void io_register(GB* gb, uint16_t addr, IoRead read, IoWrite write);
+void memory_write(GB* gb, uint16_t addr, uint8_t val);
+uint8_t memory_read(GB* gb, uint16_t addr);
+void memory_remap(GB* gb, uint8_t first_page, uint8_t last_page);
+void memory_block_vram(GB* gb, uint8_t blocked);
+void memory_init(GB* gb);
+void dma_sync(GB* gb);
 
 #endif // MEMORY_H
@@ -0,0 +1,179 @@
+// Build-time generator for the ALU lookup tables used by cpu/instructions.c when
+// ALU_TABLES is defined. Writes a header of static const arrays:
+//   gen_alu_tables <output.h>
+// The results match the branchy helpers bit for bit, those stay the reference.
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define FLAG_Z 0x80
+#define FLAG_N 0x40
+#define FLAG_H 0x20
+#define FLAG_C 0x10
+
+// CB shift/rotate order, matches ShiftOp in instructions.c
+enum { SH_RLC, SH_RRC, SH_RL, SH_RR, SH_SLA, SH_SRA, SH_SRL, SH_SWAP, SH_COUNT };
+
+static FILE* out;
+
+// One innermost row of 256 entries, in braces unless it is the whole table
+static void emit_row(const char* fmt, const void* values, int wide, int braced)
+{
+    fprintf(out, braced ? "    { " : "    ");
+    for (int i = 0; i < 256; i++)
+    {
+        unsigned v = wide ? ((const uint16_t*)values)[i] : ((const uint8_t*)values)[i];
+        fprintf(out, fmt, v);
+        fprintf(out, i < 255 ? "," : braced ? " },\n" : "\n");
+    }
+}
+
+static uint8_t add_flags(uint8_t a, uint8_t b, uint8_t carry)
+{
+    uint16_t result = a + b + carry;
+    uint8_t flags = 0;
+    if ((result & 0xFF) == 0) flags |= FLAG_Z;
+    if (((a & 0xF) + (b & 0xF) + carry) > 0xF) flags |= FLAG_H;
+    if (result > 0xFF) flags |= FLAG_C;
+    return flags;
+}
+
+static uint8_t sub_flags(uint8_t a, uint8_t b, uint8_t carry)
+{
+    uint8_t result = a - b - carry;
+    uint8_t flags = FLAG_N;
+    if (result == 0) flags |= FLAG_Z;
+    if ((a & 0xF) < ((b & 0xF) + carry)) flags |= FLAG_H;
+    if (a < b + carry) flags |= FLAG_C;
+    return flags;
+}
+
+// A in the high byte, F in the low byte. nhc holds N/H/C in bits 2..0.
+static uint16_t daa(uint8_t a, uint8_t nhc)
+{
+    uint8_t f = (uint8_t)(nhc << 4);
+    uint8_t adjust = 0;
+    uint8_t carry = 0;
+    if (!(f & FLAG_N))
+    {
+        if ((f & FLAG_H) || (a & 0x0F) > 9)
+            adjust |= 0x06;
+        if ((f & FLAG_C) || a > 0x99)
+        {
+            adjust |= 0x60;
+            carry = 1;
+        }
+        a += adjust;
+    }
+    else
+    {
+        if (f & FLAG_H)
+            adjust |= 0x06;
+        if (f & FLAG_C)
+            adjust |= 0x60;
+        a -= adjust;
+    }
+    f &= ~(FLAG_Z | FLAG_H);
+    if (a == 0) f |= FLAG_Z;
+    if (carry) f |= FLAG_C;
+    return (uint16_t)(a << 8) | f;
+}
+
+// Result in the low byte, F in the high byte
+static uint16_t shift(int op, uint8_t value, uint8_t carry)
+{
+    uint8_t result = 0, out_bit = 0;
+    switch (op)
+    {
+        case SH_RLC: out_bit = value >> 7; result = (value << 1) | out_bit; break;
+        case SH_RRC: out_bit = value & 1; result = (value >> 1) | (out_bit << 7); break;
+        case SH_RL: out_bit = value >> 7; result = (value << 1) | carry; break;
+        case SH_RR: out_bit = value & 1; result = (value >> 1) | (carry << 7); break;
+        case SH_SLA: out_bit = value >> 7; result = value << 1; break;
+        case SH_SRA: out_bit = value & 1; result = (value >> 1) | (value & 0x80); break;
+        case SH_SRL: out_bit = value & 1; result = value >> 1; break;
+        case SH_SWAP: result = (value << 4) | (value >> 4); break;
+    }
+    uint8_t flags = 0;
+    if (result == 0) flags |= FLAG_Z;
+    if (out_bit) flags |= FLAG_C;
+    return (uint16_t)(flags << 8) | result;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s <output.h>\n", argv[0]);
+        return 1;
+    }
+    out = fopen(argv[1], "w");
+    if (!out)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    uint8_t row8[256];
+    uint16_t row16[256];
+
+    fprintf(out, "// Generated by tools/gen_alu_tables.c, do not edit\n");
+    fprintf(out, "#ifndef ALU_TABLES_H\n#define ALU_TABLES_H\n\n#include <stdint.h>\n\n");
+
+    fprintf(out, "// F after ADD/ADC and SUB/SBC/CP, [carry in][a][b]\n");
+    fprintf(out, "static const uint8_t alu_add_flags[2][256][256] = {\n");
+    for (int c = 0; c < 2; c++)
+    {
+        fprintf(out, "{\n");
+        for (int a = 0; a < 256; a++)
+        {
+            for (int b = 0; b < 256; b++) row8[b] = add_flags(a, b, c);
+            emit_row("0x%02X", row8, 0, 1);
+        }
+        fprintf(out, "},\n");
+    }
+    fprintf(out, "};\n\nstatic const uint8_t alu_sub_flags[2][256][256] = {\n");
+    for (int c = 0; c < 2; c++)
+    {
+        fprintf(out, "{\n");
+        for (int a = 0; a < 256; a++)
+        {
+            for (int b = 0; b < 256; b++) row8[b] = sub_flags(a, b, c);
+            emit_row("0x%02X", row8, 0, 1);
+        }
+        fprintf(out, "},\n");
+    }
+
+    fprintf(out, "};\n\n// Z/N/H after INC/DEC, [result], C is kept from before\n");
+    fprintf(out, "static const uint8_t alu_inc_flags[256] = {\n");
+    for (int v = 0; v < 256; v++) row8[v] = (v == 0 ? FLAG_Z : 0) | ((v & 0xF) == 0x0 ? FLAG_H : 0);
+    emit_row("0x%02X", row8, 0, 0);
+    fprintf(out, "};\n\nstatic const uint8_t alu_dec_flags[256] = {\n");
+    for (int v = 0; v < 256; v++) row8[v] = FLAG_N | (v == 0 ? FLAG_Z : 0) | ((v & 0xF) == 0xF ? FLAG_H : 0);
+    emit_row("0x%02X", row8, 0, 0);
+
+    fprintf(out, "};\n\n// AF after DAA, [N/H/C as F >> 4 & 7][A]\n");
+    fprintf(out, "static const uint16_t alu_daa[8][256] = {\n");
+    for (int nhc = 0; nhc < 8; nhc++)
+    {
+        for (int a = 0; a < 256; a++) row16[a] = daa(a, nhc);
+        emit_row("0x%04X", row16, 1, 1);
+    }
+
+    fprintf(out, "};\n\n// F << 8 | result for the CB shifts, [ShiftOp][carry in][value]\n");
+    fprintf(out, "static const uint16_t alu_shift[%d][2][256] = {\n", SH_COUNT);
+    for (int op = 0; op < SH_COUNT; op++)
+    {
+        fprintf(out, "{\n");
+        for (int c = 0; c < 2; c++)
+        {
+            for (int v = 0; v < 256; v++) row16[v] = shift(op, v, c);
+            emit_row("0x%04X", row16, 1, 1);
+        }
+        fprintf(out, "},\n");
+    }
+    fprintf(out, "};\n\n#endif\n");
+
+    fclose(out);
+    return 0;
+}